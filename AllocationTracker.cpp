@@ -0,0 +1,393 @@
+#include "stdafx.h"
+
+#include "AllocationTracker.h"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+*    AllocationTracker.cpp
+*
+*	This file has the allocation hooks and the per phase counters. Every tracked block is
+*	prefixed with a small header that stores its size and the phase it was allocated in so
+*	the matching free can be attributed without a lookup. The counters are atomics in a
+*	fixed table so recording an allocation never allocates itself.
+*/
+
+const int MaxAllocationPhases = 64;
+const int MaxAllocationPhaseDepth = 16;
+
+//a power of two well above MaxAllocationPhases so probes stay short
+const int AllocationPhaseLookupSize = 256;
+
+//phase 0 collects everything allocated outside of a named phase
+struct AllocationPhaseCounters
+{
+	const char* name;
+	std::atomic<long long> allocations;
+	std::atomic<long long> bytes;
+	std::atomic<long long> frees;
+	std::atomic<long long> freedBytes;
+};
+
+//the phase of each name pointer seen so far, so switching phases is a hash probe
+struct AllocationPhaseLookup
+{
+	std::atomic<const char*> name;
+	std::atomic<int> phase;
+};
+
+AllocationPhaseCounters allocationPhases[MaxAllocationPhases];
+std::atomic<int> allocationPhaseCount(1);
+std::mutex allocationPhaseMutex;
+AllocationPhaseLookup allocationPhaseLookup[AllocationPhaseLookupSize];
+
+thread_local int allocationPhaseStack[MaxAllocationPhaseDepth];
+thread_local int allocationPhaseDepth = 0;
+
+std::atomic<long long> frameAllocations(0);
+std::atomic<long long> frameBytes(0);
+long long lastFrameAllocations = 0;
+long long lastFrameBytes = 0;
+long long peakFrameAllocations = 0;
+long long peakFrameBytes = 0;
+long long allocationFrames = 0;
+long long allocationFramesWithAllocations = 0;
+
+static int FindAllocationPhase(const char* name)
+{
+	int count = allocationPhaseCount.load(std::memory_order_acquire);
+
+	for(int i = 1; i < count; i++)
+		if(allocationPhases[i].name == name || strcmp(allocationPhases[i].name, name) == 0)
+			return i;
+
+	return -1;
+}
+
+static size_t HashAllocationPhaseName(const char* name)
+{
+	//literals are often aligned, so fold the higher address bits into the low ones
+	size_t address = (size_t)name;
+	return (address ^ (address >> 4) ^ (address >> 12)) & (AllocationPhaseLookupSize - 1);
+}
+
+/**
+*	Return the phase stored for this exact name pointer, -1 if the pointer was not seen yet
+*/
+static int LookupAllocationPhase(const char* name)
+{
+	size_t slot = HashAllocationPhaseName(name);
+
+	for(int probe = 0; probe < AllocationPhaseLookupSize; probe++)
+	{
+		AllocationPhaseLookup& entry = allocationPhaseLookup[(slot + probe) & (AllocationPhaseLookupSize - 1)];
+		const char* entryName = entry.name.load(std::memory_order_acquire);
+
+		if(entryName == name)
+			return entry.phase.load(std::memory_order_relaxed);
+		if(!entryName)
+			return -1;
+	}
+
+	return -1;
+}
+
+//called with allocationPhaseMutex held, a full table leaves the name to the string search
+static void StoreAllocationPhaseLookup(const char* name, int phase)
+{
+	size_t slot = HashAllocationPhaseName(name);
+
+	for(int probe = 0; probe < AllocationPhaseLookupSize; probe++)
+	{
+		AllocationPhaseLookup& entry = allocationPhaseLookup[(slot + probe) & (AllocationPhaseLookupSize - 1)];
+		const char* entryName = entry.name.load(std::memory_order_relaxed);
+
+		if(entryName == name)
+			return;
+		if(!entryName)
+		{
+			//the phase is written before the name publishes the entry
+			entry.phase.store(phase, std::memory_order_relaxed);
+			entry.name.store(name, std::memory_order_release);
+			return;
+		}
+	}
+}
+
+void BeginAllocationPhase(const char* name)
+{
+	int phase = LookupAllocationPhase(name);
+
+	if(phase < 0)
+	{
+		std::lock_guard<std::mutex> lock(allocationPhaseMutex);
+
+		//the same name may be a different pointer in another file, or another thread may have added it
+		phase = FindAllocationPhase(name);
+		if(phase < 0)
+		{
+			int count = allocationPhaseCount.load();
+			if(count < MaxAllocationPhases)
+			{
+				allocationPhases[count].name = name;
+				allocationPhaseCount.store(count + 1, std::memory_order_release);
+				phase = count;
+			}
+			else
+				phase = 0;
+		}
+
+		StoreAllocationPhaseLookup(name, phase);
+	}
+
+	if(allocationPhaseDepth < MaxAllocationPhaseDepth)
+		allocationPhaseStack[allocationPhaseDepth] = phase;
+	allocationPhaseDepth++;
+}
+
+void EndAllocationPhase()
+{
+	if(allocationPhaseDepth > 0)
+		allocationPhaseDepth--;
+}
+
+void EndAllocationFrame()
+{
+	lastFrameAllocations = frameAllocations.exchange(0);
+	lastFrameBytes = frameBytes.exchange(0);
+
+	if(lastFrameAllocations > peakFrameAllocations)
+		peakFrameAllocations = lastFrameAllocations;
+	if(lastFrameBytes > peakFrameBytes)
+		peakFrameBytes = lastFrameBytes;
+
+	allocationFrames++;
+	if(lastFrameAllocations > 0)
+		allocationFramesWithAllocations++;
+}
+
+long long GetFrameAllocationCount()
+{
+	return lastFrameAllocations;
+}
+
+void GetAllocationStats(std::vector<AllocationStats>& stats)
+{
+	stats.clear();
+
+	int count = allocationPhaseCount.load(std::memory_order_acquire);
+	for(int i = 0; i < count; i++)
+	{
+		AllocationStats s;
+		s.name = i == 0 ? "other" : allocationPhases[i].name;
+		s.allocations = allocationPhases[i].allocations.load();
+		s.bytes = allocationPhases[i].bytes.load();
+		s.frees = allocationPhases[i].frees.load();
+		s.freedBytes = allocationPhases[i].freedBytes.load();
+		stats.push_back(s);
+	}
+}
+
+void ReportAllocations(std::ostream& os)
+{
+	#ifndef TRACK_ALLOCATIONS
+		os << "Allocation tracking disabled, build with TRACK_ALLOCATIONS" << std::endl;
+	#else
+	std::vector<AllocationStats> stats;
+	GetAllocationStats(stats);
+
+	os << "Allocations by phase (count, bytes, live count, live bytes)" << std::endl;
+	for(size_t i = 0; i < stats.size(); i++)
+	{
+		os << "  " << stats[i].name << ": " << stats[i].allocations << ", " << stats[i].bytes << ", "
+			<< stats[i].allocations - stats[i].frees << ", " << stats[i].bytes - stats[i].freedBytes << std::endl;
+	}
+
+	os << "Frames: " << allocationFrames << " (" << allocationFramesWithAllocations << " allocated)" << std::endl;
+	os << "Last frame: " << lastFrameAllocations << " allocations, " << lastFrameBytes << " bytes" << std::endl;
+	os << "Peak frame: " << peakFrameAllocations << " allocations, " << peakFrameBytes << " bytes" << std::endl;
+	#endif
+}
+
+#ifdef TRACK_ALLOCATIONS
+
+//keeps the returned pointer aligned for any type
+union AllocationHeader
+{
+	struct
+	{
+		size_t size;
+		int phase;
+	} info;
+	max_align_t align;
+};
+
+SDL_malloc_func sdlMalloc = malloc;
+SDL_calloc_func sdlCalloc = calloc;
+SDL_realloc_func sdlRealloc = realloc;
+SDL_free_func sdlFree = free;
+
+static int CurrentAllocationPhase()
+{
+	if(allocationPhaseDepth == 0 || allocationPhaseDepth > MaxAllocationPhaseDepth)
+		return 0;
+
+	return allocationPhaseStack[allocationPhaseDepth - 1];
+}
+
+static void* RecordAllocation(void* block, size_t size)
+{
+	if(!block)
+		return nullptr;
+
+	AllocationHeader* header = (AllocationHeader*)block;
+	header->info.size = size;
+	header->info.phase = CurrentAllocationPhase();
+
+	AllocationPhaseCounters& counters = allocationPhases[header->info.phase];
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+	counters.bytes.fetch_add(size, std::memory_order_relaxed);
+	frameAllocations.fetch_add(1, std::memory_order_relaxed);
+	frameBytes.fetch_add(size, std::memory_order_relaxed);
+
+	return header + 1;
+}
+
+static void RecordFreeCounts(int phase, size_t size)
+{
+	AllocationPhaseCounters& counters = allocationPhases[phase];
+	counters.frees.fetch_add(1, std::memory_order_relaxed);
+	counters.freedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+static AllocationHeader* RecordFree(void* memory)
+{
+	AllocationHeader* header = (AllocationHeader*)memory - 1;
+	RecordFreeCounts(header->info.phase, header->info.size);
+
+	return header;
+}
+
+static void* TrackedSDLMalloc(size_t size)
+{
+	return RecordAllocation(sdlMalloc(size + sizeof(AllocationHeader)), size);
+}
+
+static void* TrackedSDLCalloc(size_t count, size_t size)
+{
+	void* memory = TrackedSDLMalloc(count * size);
+	if(memory)
+		memset(memory, 0, count * size);
+
+	return memory;
+}
+
+static void TrackedSDLFree(void* memory)
+{
+	if(memory)
+		sdlFree(RecordFree(memory));
+}
+
+static void* TrackedSDLRealloc(void* memory, size_t size)
+{
+	if(!memory)
+		return TrackedSDLMalloc(size);
+
+	//counted as a free of the old block and an allocation of the new one, but only once it
+	//succeeds since a failed realloc leaves the old block allocated
+	AllocationHeader* header = (AllocationHeader*)memory - 1;
+	int phase = header->info.phase;
+	size_t oldSize = header->info.size;
+
+	void* block = sdlRealloc(header, size + sizeof(AllocationHeader));
+	if(!block)
+		return nullptr;
+
+	RecordFreeCounts(phase, oldSize);
+	return RecordAllocation(block, size);
+}
+
+void InitializeAllocationTracker()
+{
+	SDL_GetMemoryFunctions(&sdlMalloc, &sdlCalloc, &sdlRealloc, &sdlFree);
+
+	if(SDL_SetMemoryFunctions(TrackedSDLMalloc, TrackedSDLCalloc, TrackedSDLRealloc, TrackedSDLFree) != 0)
+		std::cout << "InitializeAllocationTracker error: " << SDL_GetError() << std::endl;
+}
+
+static void* TrackedNew(size_t size)
+{
+	void* memory = RecordAllocation(malloc(size + sizeof(AllocationHeader)), size);
+	if(!memory)
+		throw std::bad_alloc();
+
+	return memory;
+}
+
+static void TrackedDelete(void* memory)
+{
+	if(memory)
+		free(RecordFree(memory));
+}
+
+void* operator new(size_t size)
+{
+	return TrackedNew(size);
+}
+
+void* operator new[](size_t size)
+{
+	return TrackedNew(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return RecordAllocation(malloc(size + sizeof(AllocationHeader)), size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return RecordAllocation(malloc(size + sizeof(AllocationHeader)), size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	TrackedDelete(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	TrackedDelete(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	TrackedDelete(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	TrackedDelete(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	TrackedDelete(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	TrackedDelete(memory);
+}
+
+#else
+
+void InitializeAllocationTracker()
+{
+}
+
+#endif //TRACK_ALLOCATIONS
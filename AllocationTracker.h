@@ -0,0 +1,113 @@
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <iostream>
+#include <vector>
+
+/**
+*    AllocationTracker.h
+*
+*	This file has the functions used to count heap allocations and attribute them to named
+*	phases such as "InitializeTextures", "frame" and "text". Tracking is opt in: build with
+*	TRACK_ALLOCATIONS defined to replace the global operator new/delete and route SDL's
+*	allocations through the tracker. Without it the phase macros compile to nothing and the
+*	report functions only print that tracking is disabled.
+*
+*	Typical use in the game loop:
+*
+*		InitializeAllocationTracker();		//before InitSDL
+*		...
+*		{
+*			ALLOCATION_PHASE("frame");
+*			//update and draw
+*		}
+*		ALLOCATION_FRAME();
+*/
+
+#ifdef TRACK_ALLOCATIONS
+	#define ALLOCATION_PHASE(name) AllocationPhase allocationPhaseScope(name)
+	#define ALLOCATION_FRAME() EndAllocationFrame()
+#else
+	#define ALLOCATION_PHASE(name)
+	#define ALLOCATION_FRAME()
+#endif
+
+/**
+*	A struct to store the allocation counts of a single phase
+*
+* @param name The name of the phase
+* @param allocations The number of allocations made during the phase
+* @param bytes The number of bytes allocated during the phase
+* @param frees The number of allocations made during the phase that have been freed
+* @param freedBytes The number of bytes allocated during the phase that have been freed
+*/
+struct AllocationStats
+{
+	const char* name;
+	long long allocations;
+	long long bytes;
+	long long frees;
+	long long freedBytes;
+};
+
+/**
+*	Route SDL's memory functions through the tracker. Must be called before any other SDL
+*	function since memory SDL allocated earlier cannot be freed by the tracker.
+*/
+void InitializeAllocationTracker();
+
+/**
+*	Start attributing allocations on this thread to the named phase. Phases nest; the
+*	innermost phase receives the allocations. The name must be a string literal or
+*	otherwise outlive the tracker.
+*
+* @param name The name of the phase
+*/
+void BeginAllocationPhase(const char* name);
+
+/**
+*	Stop attributing allocations on this thread to the current phase
+*/
+void EndAllocationPhase();
+
+/**
+*	Mark the end of a frame. The allocations made since the previous call become the
+*	last frame's counts and the peak is updated.
+*/
+void EndAllocationFrame();
+
+/**
+*	Return the number of allocations made during the last completed frame
+*/
+long long GetFrameAllocationCount();
+
+/**
+*	Fills a supplied vector with the counts of every phase seen so far
+*
+* @param stats The vector to fill; it is cleared first
+*/
+void GetAllocationStats(std::vector<AllocationStats>& stats);
+
+/**
+*	Write the counts of every phase and the per frame counts to the output stream
+*
+* @param os The output stream to write the report too
+*/
+void ReportAllocations(std::ostream& os);
+
+/**
+*	Scoped helper used by ALLOCATION_PHASE to begin a phase and end it with the scope
+*/
+struct AllocationPhase
+{
+	AllocationPhase(const char* name)
+	{
+		BeginAllocationPhase(name);
+	}
+	~AllocationPhase()
+	{
+		EndAllocationPhase();
+	}
+};
+
+#endif //ALLOCATIONTRACKER_H
@@ -16,6 +16,20 @@ enum AnimationType
 	AnimationType_OneShot
 };
 
+/**
+*	A struct to store the data of each sprite
+*
+* @param fileReference The reference of the file this sprite is stored on
+* @param spriteReference The unique name to refer to the sprite as
+* @param x The x location of the upper left pixel of the sprite
+* @param y The y location of the upper left pixel of the sprite
+* @param w The width of the sprite
+* @param h The height of the sprite
+* @param sliceLeft The width of the left border kept unstretched by DrawNineSliceSprite, 0 when not sliced
+* @param sliceTop The height of the top border
+* @param sliceRight The width of the right border
+* @param sliceBottom The height of the bottom border
+*/
 struct SpriteReference
 {
 	String fileReference;
@@ -24,25 +38,70 @@ struct SpriteReference
 	int y;
 	int w;
 	int h;
+	int sliceLeft;
+	int sliceTop;
+	int sliceRight;
+	int sliceBottom;
 };
 
+/**
+*	A struct to store the location and timing of a single animation frame
+*
+* @param mX The x location of the upper left pixel of the frame
+* @param mY The y location of the upper left pixel of the frame
+* @param mDuration How long the frame is shown, 0 to use the animation's frameDelay
+* @param mEvent A number reported when the frame is reached, 0 for none
+*/
 struct AnimationFrame
 {
 	int mX;
 	int mY;
+	float mDuration;
+	int mEvent;
 
 	AnimationFrame()
 	{
 		mX = 0;
 		mY = 0;
+		mDuration = 0.0f;
+		mEvent = 0;
 	}
 	AnimationFrame(int x, int y)
 	{
 		mX = x;
 		mY = y;
+		mDuration = 0.0f;
+		mEvent = 0;
 	}
 };
 
+/**
+*	An animation compiled into the order its frames are shown. PingPong animations are
+*	unrolled so every clip plays forward, and the arrays are sized once when compiled.
+*
+* @param steps The number of frames shown in one pass of the clip
+* @param searchSteps steps rounded up to a power of two, the length of ends
+* @param loops Whether the clip repeats; a OneShot clip holds its last frame
+* @param duration The time of one pass, in the same units as frameDelay
+* @param holdTime The time the last step starts at
+* @param rects The source rect of each step
+* @param ends The time each step ends at, padded with duration up to searchSteps
+* @param events The event of each step's frame, 0 for none
+* @param frames The animation frame each step shows
+*/
+struct AnimationClip
+{
+	int steps;
+	int searchSteps;
+	bool loops;
+	float duration;
+	float holdTime;
+	std::vector<SDL_Rect> rects;
+	std::vector<float> ends;
+	std::vector<int> events;
+	std::vector<int> frames;
+};
+
 /**
 *	A struct to store the data of each animation
 *
@@ -54,6 +113,8 @@ struct AnimationFrame
 * @param w The width of a single animation frame
 * @param h The height of a single animation frame
 * @param frames A vector of AnimationFrame structs that stores the x, y location of each frame on the image
+* @param clip The frames compiled into the order they are shown
+* @param clipDirty Whether the frames changed since the clip was compiled
 */
 struct AnimationReference
 {
@@ -65,6 +126,8 @@ struct AnimationReference
 	int w;
 	int h;
 	std::vector<AnimationFrame> frames;
+	AnimationClip clip;
+	bool clipDirty;
 };
 
 #endif //ANIMATION_H
@@ -0,0 +1,322 @@
+#include "stdafx.h"
+
+#include "Archive.h"
+#include "SDLUtil.h"
+#include "Trace.h"
+
+#include <map>
+#include <string.h>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#ifdef __ANDROID__
+	#include <jni.h>
+	#include <android/asset_manager.h>
+	#include <android/asset_manager_jni.h>
+#endif
+
+/**
+*    Archive.cpp
+*
+*	The index is read into a map when the archive is opened and every lookup after that
+*	is a map find. Names are stored with forward slashes.
+*
+*	The archive is never copied when it can be avoided. Android reads an archive packed in
+*	the APK through AAsset in buffer mode, which maps it when it is stored uncompressed.
+*	Files on disk are mapped with MapViewOfFile on Windows and mmap elsewhere. Only when
+*	both fail is the archive read into memory.
+*/
+
+struct ArchiveEntry
+{
+	Uint32 offset;
+	Uint32 size;
+};
+
+const Uint8* archiveData = nullptr;
+Uint32 archiveSize = 0;
+std::map<String, ArchiveEntry> archiveEntries;
+
+#ifdef _WIN32
+	HANDLE archiveFile = INVALID_HANDLE_VALUE;
+	HANDLE archiveMapping = nullptr;
+#else
+	void* archiveMap = nullptr;
+	size_t archiveMapSize = 0;
+	std::vector<Uint8> archiveBytes;
+#endif
+
+#ifdef __ANDROID__
+	AAsset* archiveAsset = nullptr;
+	jobject archiveAssetManager = nullptr;
+#endif
+
+static Uint32 ReadArchive32(const Uint8* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24);
+}
+
+static String ArchiveName(const String& fileName)
+{
+	String name = fileName;
+	for(size_t i = 0; i < name.length(); i++)
+		if(name[i] == '\\')
+			name[i] = '/';
+
+	return name;
+}
+
+#ifdef __ANDROID__
+
+/**
+*	Open the archive from the APK's assets. The asset manager is kept referenced while the
+*	archive is open since the asset's buffer belongs to it.
+*/
+static bool LoadArchiveAsset(const String& fileName)
+{
+	JNIEnv* env = (JNIEnv*)SDL_AndroidGetJNIEnv();
+	jobject activity = (jobject)SDL_AndroidGetActivity();
+	if(!env || !activity)
+		return false;
+
+	jclass activityClass = env->GetObjectClass(activity);
+	jmethodID getAssets = env->GetMethodID(activityClass, "getAssets", "()Landroid/content/res/AssetManager;");
+	jobject assets = getAssets ? env->CallObjectMethod(activity, getAssets) : nullptr;
+
+	if(assets)
+	{
+		archiveAssetManager = env->NewGlobalRef(assets);
+		env->DeleteLocalRef(assets);
+	}
+	env->DeleteLocalRef(activityClass);
+	env->DeleteLocalRef(activity);
+
+	AAssetManager* manager = archiveAssetManager ? AAssetManager_fromJava(env, archiveAssetManager) : nullptr;
+	if(!manager)
+		return false;
+
+	archiveAsset = AAssetManager_open(manager, fileName.c_str(), AASSET_MODE_BUFFER);
+	if(!archiveAsset)
+		return false;
+
+	off_t size = AAsset_getLength(archiveAsset);
+	const void* buffer = AAsset_getBuffer(archiveAsset);
+	if(!buffer || size <= 0 || size >= 0x7FFFFFFF)
+		return false;
+
+	archiveData = (const Uint8*)buffer;
+	archiveSize = (Uint32)size;
+
+	return true;
+}
+
+#endif //__ANDROID__
+
+#ifndef _WIN32
+
+static bool MapArchiveFile(const String& fileName)
+{
+	int file = open(fileName.c_str(), O_RDONLY);
+	if(file < 0)
+		return false;
+
+	struct stat status;
+	if(fstat(file, &status) == 0 && status.st_size > 0 && status.st_size < 0x7FFFFFFF)
+	{
+		void* map = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if(map != MAP_FAILED)
+		{
+			archiveMap = map;
+			archiveMapSize = (size_t)status.st_size;
+			archiveData = (const Uint8*)map;
+			archiveSize = (Uint32)status.st_size;
+		}
+	}
+
+	//the mapping keeps the file open on its own
+	close(file);
+
+	return archiveData != nullptr;
+}
+
+/**
+*	Read the whole archive into memory, used only when it can not be mapped
+*/
+static bool ReadArchiveFile(const String& fileName)
+{
+	SDL_RWops* rw = SDL_RWFromFile(fileName.c_str(), "rb");
+	if(!rw)
+		return false;
+
+	Sint64 size = SDL_RWsize(rw);
+	if(size > 0 && size < 0x7FFFFFFF)
+	{
+		archiveBytes.resize((size_t)size);
+		if(SDL_RWread(rw, &archiveBytes[0], (size_t)size, 1) == 1)
+		{
+			archiveData = &archiveBytes[0];
+			archiveSize = (Uint32)size;
+		}
+	}
+	SDL_RWclose(rw);
+
+	return archiveData != nullptr;
+}
+
+#endif //_WIN32
+
+static bool LoadArchiveData(const String& fileName)
+{
+	#ifdef _WIN32
+		archiveFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		LARGE_INTEGER size;
+		if(archiveFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(archiveFile, &size) || size.QuadPart <= 0 || size.QuadPart >= 0x7FFFFFFF)
+			return false;
+
+		archiveMapping = CreateFileMappingA(archiveFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(!archiveMapping)
+			return false;
+
+		archiveData = (const Uint8*)MapViewOfFile(archiveMapping, FILE_MAP_READ, 0, 0, 0);
+		archiveSize = (Uint32)size.QuadPart;
+
+		return archiveData != nullptr;
+	#else
+		#ifdef __ANDROID__
+			if(LoadArchiveAsset(fileName))
+				return true;
+		#endif
+
+		return MapArchiveFile(fileName) || ReadArchiveFile(fileName);
+	#endif
+}
+
+static bool ReadArchiveIndex()
+{
+	if(archiveSize < 16 || memcmp(archiveData, "CDPK", 4) != 0 || ReadArchive32(archiveData + 4) != ArchiveVersion)
+		return false;
+
+	Uint32 count = ReadArchive32(archiveData + 8);
+	Uint32 indexSize = ReadArchive32(archiveData + 12);
+	if(indexSize > archiveSize - 16)
+		return false;
+
+	const Uint8* p = archiveData + 16;
+	const Uint8* end = p + indexSize;
+
+	for(Uint32 i = 0; i < count; i++)
+	{
+		if(end - p < 12)
+			return false;
+
+		ArchiveEntry entry;
+		entry.offset = ReadArchive32(p);
+		entry.size = ReadArchive32(p + 4);
+		Uint32 nameLength = ReadArchive32(p + 8);
+		p += 12;
+
+		if((Uint32)(end - p) < nameLength || entry.offset > archiveSize || entry.size > archiveSize - entry.offset)
+			return false;
+
+		archiveEntries[String((const char*)p, nameLength)] = entry;
+		p += nameLength;
+	}
+
+	return true;
+}
+
+bool OpenAssetArchive(const String& fileName)
+{
+	TRACE_SCOPE_ASSET("OpenAssetArchive", fileName);
+
+	CloseAssetArchive();
+
+	if(!LoadArchiveData(fileName))
+	{
+		logError(std::cout, "OpenAssetArchive: error opening: " + fileName);
+		CloseAssetArchive();
+		return false;
+	}
+
+	if(!ReadArchiveIndex())
+	{
+		logError(std::cout, "OpenAssetArchive: " + fileName + " is not a valid archive");
+		CloseAssetArchive();
+		return false;
+	}
+
+	TRACE_BYTES(archiveSize);
+
+	return true;
+}
+
+void CloseAssetArchive()
+{
+	#ifdef _WIN32
+		if(archiveData)
+			UnmapViewOfFile(archiveData);
+		if(archiveMapping)
+			CloseHandle(archiveMapping);
+		if(archiveFile != INVALID_HANDLE_VALUE)
+			CloseHandle(archiveFile);
+
+		archiveMapping = nullptr;
+		archiveFile = INVALID_HANDLE_VALUE;
+	#else
+		if(archiveMap)
+			munmap(archiveMap, archiveMapSize);
+
+		archiveMap = nullptr;
+		archiveMapSize = 0;
+		std::vector<Uint8>().swap(archiveBytes);
+	#endif
+
+	#ifdef __ANDROID__
+		if(archiveAsset)
+			AAsset_close(archiveAsset);
+		if(archiveAssetManager)
+			((JNIEnv*)SDL_AndroidGetJNIEnv())->DeleteGlobalRef(archiveAssetManager);
+
+		archiveAsset = nullptr;
+		archiveAssetManager = nullptr;
+	#endif
+
+	archiveData = nullptr;
+	archiveSize = 0;
+	archiveEntries.clear();
+}
+
+const Uint8* GetArchivedAsset(const String& fileName, int* size)
+{
+	if(archiveEntries.empty())
+		return nullptr;
+
+	std::map<String, ArchiveEntry>::iterator it = archiveEntries.find(ArchiveName(fileName));
+	if(it == archiveEntries.end())
+		return nullptr;
+
+	*size = (int)it->second.size;
+
+	return archiveData + it->second.offset;
+}
+
+SDL_RWops* OpenAssetFile(const String& fileName)
+{
+	int size;
+	const Uint8* data = GetArchivedAsset(fileName, &size);
+
+	if(data)
+		return SDL_RWFromConstMem(data, size);
+
+	return SDL_RWFromFile(fileName.c_str(), "rb");
+}
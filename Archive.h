@@ -0,0 +1,63 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "StringUtil.h"
+
+/**
+*    Archive.h
+*
+*	This file has the asset archive. tools/PackArchive packs the game's images, data files
+*	and fonts into one file with an index, and once it is opened every loader reads the
+*	packed copy instead of opening the file on its own. The archive is memory mapped, or
+*	on Android read through the APK's asset buffer, so startup makes a single open and
+*	only the parts that are used are paged in. Files missing from the archive are still
+*	read from disk.
+*
+*		OpenAssetArchive("assets.pak");
+*		InitializeTextures(renderer);
+*
+*	The archive starts with the magic "CDPK", the version, the entry count and the index
+*	size, all 32 bit little endian. The index follows with the offset, size and name
+*	length of each entry and then the name. File data starts after the index, each entry
+*	aligned to ArchiveAlignment bytes from the start of the archive.
+*/
+
+/**
+*	The alignment of every entry's data, so images and fonts can be read in place
+*/
+const int ArchiveAlignment = 16;
+
+const Uint32 ArchiveVersion = 1;
+
+/**
+*	Open an archive, replacing any archive already open
+*
+* @param fileName The path and name of the archive
+* @return bool True if the archive was opened; false if it is missing or damaged
+*/
+bool OpenAssetArchive(const String& fileName);
+
+/**
+*	Close the archive. Textures, fonts and surfaces already loaded are unaffected, except
+*	fonts opened from the archive, so call ShutdownFonts first.
+*/
+void CloseAssetArchive();
+
+/**
+*	Return the bytes of a packed file, which stay valid until the archive is closed
+*
+* @param fileName The path and name of the file as it was packed, such as "image/sprites.png"
+* @param size Filled with the number of bytes
+* @return const Uint8* The bytes, nullptr if the file is not in the archive
+*/
+const Uint8* GetArchivedAsset(const String& fileName, int* size);
+
+/**
+*	Open a file from the archive, or from disk when it is not packed
+*
+* @param fileName The path and name of the file
+* @return SDL_RWops* A read only RWops to close with SDL_RWclose, nullptr if the file was not found
+*/
+SDL_RWops* OpenAssetFile(const String& fileName);
+
+#endif //ARCHIVE_H
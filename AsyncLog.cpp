@@ -0,0 +1,211 @@
+#include "stdafx.h"
+
+#include "AsyncLog.h"
+#include "SDLUtil.h"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <string.h>
+#include <stdlib.h>
+
+/**
+*    AsyncLog.cpp
+*
+*	The ring is a bounded multiple producer, single consumer queue. Each slot has a
+*	sequence number: a producer claims a position with a compare and swap on the write
+*	position, fills the slot and then publishes it by moving the sequence on, and the
+*	background thread reads slots in order once they are published.
+*
+*	Repeats are limited with a fixed table of atomics indexed by a hash of the site and
+*	reference, so no lock or allocation is needed to decide whether to log. Two
+*	references sharing an entry only share their limit.
+*/
+
+struct LogSlot
+{
+	std::atomic<size_t> sequence;
+	const char* site;
+	char reference[LogReferenceLength];
+	Uint32 skipped;
+};
+
+struct LogRepeat
+{
+	std::atomic<Uint32> lastLogged;
+	std::atomic<Uint32> skipped;
+};
+
+const int LogRepeatTableSize = 1024;
+
+LogSlot logRing[LogRingSize];
+LogRepeat logRepeats[LogRepeatTableSize];
+std::atomic<size_t> logWritePosition(0);
+size_t logReadPosition = 0;
+std::atomic<Uint32> logDropped(0);
+
+std::thread logThread;
+std::atomic<bool> logRunning(false);
+std::atomic<bool> logShutdown(false);
+std::once_flag logStartFlag;
+
+static void WriteNotFound(const char* site, const char* reference, Uint32 skipped)
+{
+	String message = String(site) + ": warning " + reference + " not found";
+	if(skipped > 0)
+		message += " (" + IntToString((int)skipped) + " more since last shown)";
+
+	std::cout << "Error: " << message << '\n';
+
+	#if defined(__ANDROID__)
+		__android_log_write(ANDROID_LOG_ERROR, "Chain Drop", message.c_str());
+	#endif
+}
+
+/**
+*	Write every published warning, returns whether any were written
+*/
+static bool DrainLogRing()
+{
+	bool wrote = false;
+
+	while(true)
+	{
+		LogSlot& slot = logRing[logReadPosition % LogRingSize];
+		if(slot.sequence.load(std::memory_order_acquire) != logReadPosition + 1)
+			break;
+
+		WriteNotFound(slot.site, slot.reference, slot.skipped);
+
+		//free the slot for the producer one lap ahead
+		slot.sequence.store(logReadPosition + LogRingSize, std::memory_order_release);
+		logReadPosition++;
+		wrote = true;
+	}
+
+	Uint32 dropped = logDropped.exchange(0);
+	if(dropped > 0)
+	{
+		std::cout << "Error: logNotFound: " << dropped << " warnings dropped, the log ring was full\n";
+		wrote = true;
+	}
+
+	if(wrote)
+		std::cout.flush();
+
+	return wrote;
+}
+
+static void LogThreadMain()
+{
+	while(logRunning.load(std::memory_order_acquire))
+	{
+		if(!DrainLogRing())
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	DrainLogRing();
+}
+
+static void StartLogThread()
+{
+	if(logShutdown.load(std::memory_order_acquire))
+		return;
+
+	for(size_t i = 0; i < (size_t)LogRingSize; i++)
+		logRing[i].sequence.store(i, std::memory_order_relaxed);
+
+	logRunning.store(true, std::memory_order_release);
+	logThread = std::thread(LogThreadMain);
+
+	//the thread must be joined before the globals are destroyed, even if the game never calls ShutdownAsyncLog
+	atexit(ShutdownAsyncLog);
+}
+
+static Uint32 HashLogReference(const char* site, const char* reference, size_t length)
+{
+	//FNV-1a over the site's address and the reference
+	Uint32 hash = 2166136261u ^ (Uint32)(size_t)site;
+	for(size_t i = 0; i < length; i++)
+		hash = (hash ^ (Uint8)reference[i]) * 16777619u;
+
+	return hash;
+}
+
+void logNotFound(const char* site, const String& reference)
+{
+	logNotFound(site, reference.c_str());
+}
+
+void logNotFound(const char* site, const char* reference)
+{
+	size_t referenceLength = strlen(reference);
+
+	if(logShutdown.load(std::memory_order_acquire))
+	{
+		WriteNotFound(site, reference, 0);
+		std::cout.flush();
+		return;
+	}
+
+	LogRepeat& repeat = logRepeats[HashLogReference(site, reference, referenceLength) % LogRepeatTableSize];
+
+	//0 is kept for never logged
+	Uint32 now = SDL_GetTicks() | 1;
+	Uint32 last = repeat.lastLogged.load(std::memory_order_relaxed);
+	if((last != 0 && now - last < LogRepeatDelay) || !repeat.lastLogged.compare_exchange_strong(last, now))
+	{
+		repeat.skipped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	std::call_once(logStartFlag, StartLogThread);
+
+	if(!logRunning.load(std::memory_order_acquire))
+	{
+		WriteNotFound(site, reference, repeat.skipped.exchange(0, std::memory_order_relaxed));
+		std::cout.flush();
+		return;
+	}
+
+	size_t position = logWritePosition.load(std::memory_order_relaxed);
+	LogSlot* slot;
+
+	while(true)
+	{
+		slot = &logRing[position % LogRingSize];
+		size_t sequence = slot->sequence.load(std::memory_order_acquire);
+
+		if(sequence == position)
+		{
+			if(logWritePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if(sequence < position)
+		{
+			//the ring is full, the background thread has not freed this slot yet
+			logDropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+			position = logWritePosition.load(std::memory_order_relaxed);
+	}
+
+	slot->site = site;
+	size_t length = SDL_min(referenceLength, (size_t)LogReferenceLength - 1);
+	memcpy(slot->reference, reference, length);
+	slot->reference[length] = '\0';
+	slot->skipped = repeat.skipped.exchange(0, std::memory_order_relaxed);
+
+	slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+void ShutdownAsyncLog()
+{
+	if(logShutdown.exchange(true))
+		return;
+
+	if(logRunning.exchange(false))
+		logThread.join();
+}
@@ -0,0 +1,58 @@
+#ifndef ASYNCLOG_H
+#define ASYNCLOG_H
+
+#include "StringUtil.h"
+
+/**
+*    AsyncLog.h
+*
+*	This file has the logger used for warnings on the lookup hot path, such as a missing
+*	sprite asked for every frame. Warnings are put on a lock-free ring and written by a
+*	background thread, so the caller never waits on output. The message is only put
+*	together on that thread; the caller copies the reference name and nothing else.
+*
+*	A warning for the same site and reference is written at most once every
+*	LogRepeatDelay milliseconds. The next one written says how many were skipped.
+*
+*		logNotFound("GetSpriteReference", spriteReference);
+*/
+
+/**
+*	The number of warnings the ring holds before new ones are dropped
+*/
+const int LogRingSize = 1024;
+
+/**
+*	The longest reference name copied with a warning, longer names keep their start
+*/
+const int LogReferenceLength = 64;
+
+/**
+*	The time in milliseconds before the same warning is written again
+*/
+const Uint32 LogRepeatDelay = 5000;
+
+/**
+*	Log that a reference was not found, written as "Error: site: warning reference not found"
+*
+* @param site The function that failed, must be a string literal
+* @param reference The reference that was not found
+*/
+void logNotFound(const char* site, const String& reference);
+
+/**
+*	Log that a reference was not found, for callers that put the reference together in a
+*	buffer of their own rather than a String
+*
+* @param site The function that failed, must be a string literal
+* @param reference The reference that was not found, copied before this returns
+*/
+void logNotFound(const char* site, const char* reference);
+
+/**
+*	Write every queued warning and stop the background thread. Warnings logged after
+*	this are written straight away. Call once before shutting down the game.
+*/
+void ShutdownAsyncLog();
+
+#endif //ASYNCLOG_H
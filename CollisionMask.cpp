@@ -0,0 +1,145 @@
+#include "stdafx.h"
+
+#include "CollisionMask.h"
+#include "SDLUtil.h"
+
+#include <algorithm>
+
+/**
+*    CollisionMask.cpp
+*
+*	Every function reads a row 64 pixels at a time starting at any pixel, joining the two
+*	words the run spans, so masks can be copied and compared at any offset.
+*/
+
+static void ResizeCollisionMask(CollisionMask& mask, int w, int h)
+{
+	mask.w = std::max(w, 0);
+	mask.h = std::max(h, 0);
+	mask.wordsPerRow = (mask.w + 63) / 64;
+	mask.words.assign(mask.wordsPerRow * mask.h, 0);
+}
+
+/**
+*	Return the 64 pixels of a row starting at x. Pixels past the row are 0.
+*/
+static inline Uint64 ReadMaskBits(const Uint64* row, int wordsPerRow, int x)
+{
+	int word = x >> 6;
+	int shift = x & 63;
+
+	if(word >= wordsPerRow)
+		return 0;
+
+	Uint64 bits = row[word] >> shift;
+	if(shift != 0 && word + 1 < wordsPerRow)
+		bits |= row[word + 1] << (64 - shift);
+
+	return bits;
+}
+
+static inline Uint64 LowBits(int count)
+{
+	return count >= 64 ? ~(Uint64)0 : (((Uint64)1 << count) - 1);
+}
+
+bool BuildCollisionMask(SDL_Surface* surface, CollisionMask& mask)
+{
+	ResizeCollisionMask(mask, 0, 0);
+
+	if(!surface)
+		return false;
+
+	SDL_Surface* argb = surface;
+	if(surface->format->format != SDL_PIXELFORMAT_ARGB8888)
+	{
+		argb = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		if(!argb)
+		{
+			logSDLError(std::cout, "BuildCollisionMask");
+			return false;
+		}
+	}
+
+	ResizeCollisionMask(mask, argb->w, argb->h);
+
+	if(SDL_MUSTLOCK(argb))
+		SDL_LockSurface(argb);
+
+	for(int y = 0; y < argb->h; y++)
+	{
+		const Uint32* pixels = (const Uint32*)((const Uint8*)argb->pixels + y * argb->pitch);
+		Uint64* row = &mask.words[y * mask.wordsPerRow];
+
+		for(int x = 0; x < argb->w; x++)
+			if((pixels[x] >> 24) >= CollisionAlphaThreshold)
+				row[x >> 6] |= (Uint64)1 << (x & 63);
+	}
+
+	if(SDL_MUSTLOCK(argb))
+		SDL_UnlockSurface(argb);
+
+	if(argb != surface)
+		SDL_FreeSurface(argb);
+
+	return true;
+}
+
+void CopyCollisionMask(const CollisionMask& source, int x, int y, int w, int h, CollisionMask& mask)
+{
+	ResizeCollisionMask(mask, w, h);
+
+	//columns left of the source are shifted in as empty
+	int skip = x < 0 ? -x : 0;
+
+	for(int row = 0; row < mask.h; row++)
+	{
+		int sourceRow = y + row;
+		if(sourceRow < 0 || sourceRow >= source.h)
+			continue;
+
+		const Uint64* from = &source.words[sourceRow * source.wordsPerRow];
+		Uint64* to = &mask.words[row * mask.wordsPerRow];
+
+		for(int i = 0; i < mask.wordsPerRow; i++)
+		{
+			int start = i * 64;
+			Uint64 bits;
+
+			if(start + 64 <= skip)
+				continue;
+			else if(start >= skip)
+				bits = ReadMaskBits(from, source.wordsPerRow, x + start);
+			else
+				bits = ReadMaskBits(from, source.wordsPerRow, 0) << (skip - start);
+
+			to[i] = bits & LowBits(mask.w - start);
+		}
+	}
+}
+
+bool MasksOverlap(const CollisionMask& a, int ax, int ay, const CollisionMask& b, int bx, int by)
+{
+	int left = std::max(ax, bx);
+	int right = std::min(ax + a.w, bx + b.w);
+	int top = std::max(ay, by);
+	int bottom = std::min(ay + a.h, by + b.h);
+
+	if(left >= right || top >= bottom)
+		return false;
+
+	for(int y = top; y < bottom; y++)
+	{
+		const Uint64* rowA = &a.words[(y - ay) * a.wordsPerRow];
+		const Uint64* rowB = &b.words[(y - by) * b.wordsPerRow];
+
+		for(int x = left; x < right; x += 64)
+		{
+			Uint64 bits = ReadMaskBits(rowA, a.wordsPerRow, x - ax) & ReadMaskBits(rowB, b.wordsPerRow, x - bx);
+			if(bits & LowBits(right - x))
+				return true;
+		}
+	}
+
+	return false;
+}
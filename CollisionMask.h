@@ -0,0 +1,78 @@
+#ifndef COLLISIONMASK_H
+#define COLLISIONMASK_H
+
+/**
+*    CollisionMask.h
+*
+*	This file has the 1 bit alpha masks used for pixel perfect collisions. Each row of a
+*	mask is packed into 64 bit words, leftmost pixel in the lowest bit, with a bit set for
+*	every pixel at least CollisionAlphaThreshold opaque. Two placed masks are tested 64
+*	pixels at a time by shifting one row into line with the other and ANDing the words.
+*
+*	Masks are built by the texture registry for files loaded with collision masks, see
+*	LoadFile, GetSpriteCollisionMask and GetAnimationCollisionMask.
+*/
+
+/**
+*	Pixels with at least this alpha are solid
+*/
+const Uint8 CollisionAlphaThreshold = 128;
+
+/**
+*	A packed 1 bit mask
+*
+* @param w The width in pixels
+* @param h The height in pixels
+* @param wordsPerRow The number of 64 bit words holding each row
+* @param words The rows, top to bottom. Bits past the width are always 0.
+*/
+struct CollisionMask
+{
+	int w;
+	int h;
+	int wordsPerRow;
+	std::vector<Uint64> words;
+
+	CollisionMask()
+	{
+		w = 0;
+		h = 0;
+		wordsPerRow = 0;
+	}
+};
+
+/**
+* Build a mask of a whole surface from its alpha channel
+*
+* @param surface The surface, any format SDL can convert
+* @param mask The mask to fill
+* @return bool True if the mask was built
+*/
+bool BuildCollisionMask(SDL_Surface* surface, CollisionMask& mask);
+
+/**
+* Copy part of a mask into a new mask. Pixels outside the source are empty.
+*
+* @param source The mask to copy from, usually the mask of a whole file
+* @param x The x location of the upper left pixel to copy
+* @param y The y location of the upper left pixel to copy
+* @param w The width to copy
+* @param h The height to copy
+* @param mask The mask to fill
+*/
+void CopyCollisionMask(const CollisionMask& source, int x, int y, int w, int h, CollisionMask& mask);
+
+/**
+* Return whether two placed masks have a solid pixel in the same place
+*
+* @param a The first mask
+* @param ax The x location of the first mask's upper left pixel
+* @param ay The y location of the first mask's upper left pixel
+* @param b The second mask
+* @param bx The x location of the second mask's upper left pixel
+* @param by The y location of the second mask's upper left pixel
+* @return bool True if the masks overlap
+*/
+bool MasksOverlap(const CollisionMask& a, int ax, int ay, const CollisionMask& b, int bx, int by);
+
+#endif //COLLISIONMASK_H
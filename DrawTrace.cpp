@@ -0,0 +1,619 @@
+#include "stdafx.h"
+
+#include "DrawTrace.h"
+
+#include <map>
+#include <fstream>
+
+/**
+*    DrawTrace.cpp
+*
+*	A trace starts with the magic "DTRC" and a version and is followed by records. Every
+*	record is a one byte op and its values, little endian. Strings are written once with
+*	DrawTraceOp_String and then referred to by id. Textures and fonts are referred to by
+*	ids handed out the first time their pointer is seen. A text texture or font created at
+*	the address of one that was destroyed gets a new id, so the replay frees the old one
+*	at the same point.
+*
+*	Lookups and text renders bind their texture's id on replay. A texture first seen in a
+*	draw, such as one cached by a sprite instance or looked up before recording started,
+*	gets a DrawTraceOp_BindTexture record first naming its file reference, or its size
+*	and format when it was not loaded from a file so the replay can make a stand in.
+*/
+
+enum DrawTraceOp
+{
+	DrawTraceOp_String = 1,
+	DrawTraceOp_Frame,
+	DrawTraceOp_LoadFont,
+	DrawTraceOp_GetTexture,
+	DrawTraceOp_GetTextureFileReference,
+	DrawTraceOp_SpriteSourceRect,
+	DrawTraceOp_AnimationSourceRect,
+	DrawTraceOp_RenderText,
+	DrawTraceOp_RenderOutlinedText,
+	DrawTraceOp_DrawTexture,
+	DrawTraceOp_CopyTexture,
+	DrawTraceOp_BindTexture
+};
+
+enum DrawTraceBinding
+{
+	DrawTraceBinding_FileReference,
+	DrawTraceBinding_Generated
+};
+
+const Uint32 DrawTraceVersion = 3;
+
+bool drawTraceRecording = false;
+std::ofstream drawTraceFile;
+std::vector<Uint8> drawTraceBuffer;
+std::map<String, Uint32> drawTraceStrings;
+std::map<SDL_Texture*, Uint32> drawTraceTextures;
+std::map<TTF_Font*, Uint32> drawTraceFonts;
+Uint32 drawTraceNextTextureId = 1;
+Uint32 drawTraceNextFontId = 1;
+
+static void WriteU8(Uint8 value)
+{
+	drawTraceBuffer.push_back(value);
+}
+
+static void WriteU32(Uint32 value)
+{
+	drawTraceBuffer.push_back((Uint8)value);
+	drawTraceBuffer.push_back((Uint8)(value >> 8));
+	drawTraceBuffer.push_back((Uint8)(value >> 16));
+	drawTraceBuffer.push_back((Uint8)(value >> 24));
+}
+
+static void WriteI32(int value)
+{
+	WriteU32((Uint32)value);
+}
+
+static void WriteColor(SDL_Color color)
+{
+	WriteU32(color.r | (color.g << 8) | (color.b << 16) | ((Uint32)color.a << 24));
+}
+
+static void WriteRect(const SDL_Rect* rect)
+{
+	//a missing rect is written with a negative width
+	SDL_Rect empty = {0, 0, -1, -1};
+	if(!rect)
+		rect = &empty;
+
+	WriteI32(rect->x);
+	WriteI32(rect->y);
+	WriteI32(rect->w);
+	WriteI32(rect->h);
+}
+
+static Uint32 StringId(const String& s)
+{
+	std::map<String, Uint32>::iterator it = drawTraceStrings.find(s);
+	if(it != drawTraceStrings.end())
+		return it->second;
+
+	Uint32 id = (Uint32)drawTraceStrings.size();
+	drawTraceStrings[s] = id;
+
+	WriteU8(DrawTraceOp_String);
+	WriteU32(id);
+	WriteU32((Uint32)s.length());
+	drawTraceBuffer.insert(drawTraceBuffer.end(), s.begin(), s.end());
+
+	return id;
+}
+
+/**
+*	Return the id of a texture whose record binds it on replay, a lookup or text render.
+*	0 is kept for nullptr.
+*/
+static Uint32 BoundTextureId(SDL_Texture* texture)
+{
+	if(!texture)
+		return 0;
+
+	std::map<SDL_Texture*, Uint32>::iterator it = drawTraceTextures.find(texture);
+	if(it != drawTraceTextures.end())
+		return it->second;
+
+	Uint32 id = drawTraceNextTextureId++;
+	drawTraceTextures[texture] = id;
+
+	return id;
+}
+
+/**
+*	Return the id of a texture being drawn, writing a binding record the first time it is seen.
+*	Call before writing the op of the record that uses the id.
+*/
+static Uint32 TextureId(SDL_Texture* texture)
+{
+	if(!texture || drawTraceTextures.find(texture) != drawTraceTextures.end())
+		return BoundTextureId(texture);
+
+	Uint32 id = BoundTextureId(texture);
+
+	String fileReference = FindTextureFileReferenceName(texture);
+	if(!fileReference.empty())
+	{
+		Uint32 referenceId = StringId(fileReference);
+		WriteU8(DrawTraceOp_BindTexture);
+		WriteU32(id);
+		WriteU8(DrawTraceBinding_FileReference);
+		WriteU32(referenceId);
+	}
+	else
+	{
+		Uint32 format = 0;
+		int access = 0, w = 0, h = 0;
+		SDL_QueryTexture(texture, &format, &access, &w, &h);
+
+		WriteU8(DrawTraceOp_BindTexture);
+		WriteU32(id);
+		WriteU8(DrawTraceBinding_Generated);
+		WriteU32(format);
+		WriteI32(access);
+		WriteI32(w);
+		WriteI32(h);
+	}
+
+	return id;
+}
+
+static Uint32 FontId(TTF_Font* font)
+{
+	if(!font)
+		return 0;
+
+	std::map<TTF_Font*, Uint32>::iterator it = drawTraceFonts.find(font);
+	if(it != drawTraceFonts.end())
+		return it->second;
+
+	Uint32 id = drawTraceNextFontId++;
+	drawTraceFonts[font] = id;
+
+	return id;
+}
+
+bool StartDrawTraceRecording(const String& fileName)
+{
+	StopDrawTraceRecording();
+
+	drawTraceFile.open(fileName.c_str(), std::ios::binary | std::ios::trunc);
+	if(!drawTraceFile.is_open())
+	{
+		logError(std::cout, "StartDrawTraceRecording: error opening: " + fileName);
+		return false;
+	}
+
+	drawTraceBuffer.clear();
+	drawTraceBuffer.push_back('D');
+	drawTraceBuffer.push_back('T');
+	drawTraceBuffer.push_back('R');
+	drawTraceBuffer.push_back('C');
+	WriteU32(DrawTraceVersion);
+
+	drawTraceRecording = true;
+
+	return true;
+}
+
+static void FlushDrawTrace()
+{
+	if(!drawTraceBuffer.empty())
+		drawTraceFile.write((const char*)&drawTraceBuffer[0], drawTraceBuffer.size());
+
+	drawTraceBuffer.clear();
+}
+
+void StopDrawTraceRecording()
+{
+	if(drawTraceFile.is_open())
+	{
+		FlushDrawTrace();
+		drawTraceFile.close();
+	}
+
+	drawTraceRecording = false;
+	drawTraceStrings.clear();
+	drawTraceTextures.clear();
+	drawTraceFonts.clear();
+	drawTraceNextTextureId = 1;
+	drawTraceNextFontId = 1;
+}
+
+void RecordDrawTraceFrame()
+{
+	if(!drawTraceRecording)
+		return;
+
+	WriteU8(DrawTraceOp_Frame);
+	FlushDrawTrace();
+}
+
+void TraceLoadFont(const String& file, int fontSize, int outline, TTF_Font* font)
+{
+	//a new font at an old address replaces the old one
+	drawTraceFonts.erase(font);
+
+	Uint32 fileId = StringId(file);
+	WriteU8(DrawTraceOp_LoadFont);
+	WriteU32(FontId(font));
+	WriteU32(fileId);
+	WriteI32(fontSize);
+	WriteI32(outline);
+}
+
+void TraceGetFont(const String& file, int fontSize, int outline, TTF_Font* font)
+{
+	//cached fonts opened before recording started are loaded the first time they are used
+	if(drawTraceFonts.find(font) == drawTraceFonts.end())
+		TraceLoadFont(file, fontSize, outline, font);
+}
+
+void TraceGetTexture(TextureType type, const String& reference, SDL_Texture* texture)
+{
+	Uint32 referenceId = StringId(reference);
+	WriteU8(DrawTraceOp_GetTexture);
+	WriteU8((Uint8)type);
+	WriteU32(referenceId);
+	WriteU32(BoundTextureId(texture));
+}
+
+void TraceGetTextureFileReference(const String& fileReference, SDL_Texture* texture)
+{
+	Uint32 referenceId = StringId(fileReference);
+	WriteU8(DrawTraceOp_GetTextureFileReference);
+	WriteU32(referenceId);
+	WriteU32(BoundTextureId(texture));
+}
+
+void TraceSpriteSourceRect(const String& spriteReference)
+{
+	Uint32 referenceId = StringId(spriteReference);
+	WriteU8(DrawTraceOp_SpriteSourceRect);
+	WriteU32(referenceId);
+}
+
+void TraceAnimationSourceRect(const String& animationReference, int frame)
+{
+	Uint32 referenceId = StringId(animationReference);
+	WriteU8(DrawTraceOp_AnimationSourceRect);
+	WriteU32(referenceId);
+	WriteI32(frame);
+}
+
+void TraceRenderText(const String& message, SDL_Color color, TTF_Font* font, SDL_Texture* texture)
+{
+	//text textures are created fresh so a known address means the old one was destroyed
+	drawTraceTextures.erase(texture);
+
+	Uint32 messageId = StringId(message);
+	WriteU8(DrawTraceOp_RenderText);
+	WriteU32(messageId);
+	WriteColor(color);
+	WriteU32(FontId(font));
+	WriteU32(BoundTextureId(texture));
+}
+
+void TraceRenderOutlinedText(const String& message, SDL_Color color, SDL_Color outlineColor,
+								TTF_Font* font, TTF_Font* outlineFont, SDL_Texture* texture)
+{
+	drawTraceTextures.erase(texture);
+
+	Uint32 messageId = StringId(message);
+	WriteU8(DrawTraceOp_RenderOutlinedText);
+	WriteU32(messageId);
+	WriteColor(color);
+	WriteColor(outlineColor);
+	WriteU32(FontId(font));
+	WriteU32(FontId(outlineFont));
+	WriteU32(BoundTextureId(texture));
+}
+
+void TraceDrawTexture(SDL_Texture* texture, int x, int y)
+{
+	Uint32 textureId = TextureId(texture);
+	WriteU8(DrawTraceOp_DrawTexture);
+	WriteU32(textureId);
+	WriteI32(x);
+	WriteI32(y);
+}
+
+void TraceCopyTexture(SDL_Texture* texture, const SDL_Rect* source, const SDL_Rect* destination)
+{
+	Uint32 textureId = TextureId(texture);
+	WriteU8(DrawTraceOp_CopyTexture);
+	WriteU32(textureId);
+	WriteRect(source);
+	WriteRect(destination);
+}
+
+/**
+*	Reads values from a loaded trace, failing once it runs past the end
+*/
+struct DrawTraceReader
+{
+	const std::vector<Uint8>& data;
+	size_t position;
+	bool failed;
+
+	DrawTraceReader(const std::vector<Uint8>& traceData) : data(traceData), position(0), failed(false)
+	{
+	}
+
+	bool Has(size_t count)
+	{
+		if(position + count > data.size())
+			failed = true;
+		return !failed;
+	}
+
+	Uint8 U8()
+	{
+		return Has(1) ? data[position++] : 0;
+	}
+
+	Uint32 U32()
+	{
+		if(!Has(4))
+			return 0;
+
+		Uint32 value = data[position] | (data[position + 1] << 8) | (data[position + 2] << 16) | ((Uint32)data[position + 3] << 24);
+		position += 4;
+		return value;
+	}
+
+	int I32()
+	{
+		return (int)U32();
+	}
+
+	SDL_Color Color()
+	{
+		Uint32 value = U32();
+		SDL_Color color = {(Uint8)value, (Uint8)(value >> 8), (Uint8)(value >> 16), (Uint8)(value >> 24)};
+		return color;
+	}
+
+	bool Rect(SDL_Rect* rect)
+	{
+		rect->x = I32();
+		rect->y = I32();
+		rect->w = I32();
+		rect->h = I32();
+		return rect->w >= 0;
+	}
+};
+
+static String TraceString(const std::vector<String>& strings, Uint32 id)
+{
+	return id < strings.size() ? strings[id] : String();
+}
+
+/**
+*	Return the texture bound to an id, nullptr for id 0 or an id nothing was bound to
+*/
+static SDL_Texture* FindBoundTexture(const std::map<Uint32, SDL_Texture*>& textures, Uint32 id)
+{
+	std::map<Uint32, SDL_Texture*>::const_iterator it = textures.find(id);
+	return it == textures.end() ? nullptr : it->second;
+}
+
+bool ReplayDrawTrace(const String& fileName, SDL_Renderer* renderer, std::vector<double>& frameTimes)
+{
+	std::ifstream file(fileName.c_str(), std::ios::binary);
+
+	if(!file.is_open())
+	{
+		logError(std::cout, "ReplayDrawTrace: error opening: " + fileName);
+		return false;
+	}
+
+	//read it all up front so file reads are not timed
+	std::vector<Uint8> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+
+	DrawTraceReader reader(data);
+
+	if(!reader.Has(8) || data[0] != 'D' || data[1] != 'T' || data[2] != 'R' || data[3] != 'C')
+	{
+		logError(std::cout, "ReplayDrawTrace: " + fileName + " is not a draw trace");
+		return false;
+	}
+	reader.position = 4;
+	if(reader.U32() != DrawTraceVersion)
+	{
+		logError(std::cout, "ReplayDrawTrace: " + fileName + " has an unknown version");
+		return false;
+	}
+
+	std::vector<String> strings;
+	std::map<Uint32, SDL_Texture*> textures;
+	std::map<Uint32, SDL_Texture*> textTextures;
+	std::vector<SDL_Texture*> standInTextures;
+	std::map<Uint32, TTF_Font*> fonts;
+	SDL_Rect source, destination;
+	bool unbound = false;
+
+	frameTimes.clear();
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 frameStart = SDL_GetPerformanceCounter();
+
+	while(reader.position < data.size() && !reader.failed)
+	{
+		Uint8 op = reader.U8();
+
+		if(op == DrawTraceOp_String)
+		{
+			Uint32 id = reader.U32();
+			Uint32 length = reader.U32();
+			if(!reader.Has(length))
+				break;
+			if(id >= strings.size())
+				strings.resize(id + 1);
+			strings[id].assign((const char*)&data[reader.position], length);
+			reader.position += length;
+			continue;
+		}
+
+		if(op == DrawTraceOp_Frame)
+		{
+			SDL_RenderPresent(renderer);
+			Uint64 now = SDL_GetPerformanceCounter();
+			frameTimes.push_back((double)(now - frameStart) * 1000.0 / (double)frequency);
+			SDL_RenderClear(renderer);
+			frameStart = SDL_GetPerformanceCounter();
+		}
+		else if(op == DrawTraceOp_LoadFont)
+		{
+			Uint32 id = reader.U32();
+			String file = TraceString(strings, reader.U32());
+			int size = reader.I32();
+			int outline = reader.I32();
+			if(fonts[id])
+				TTF_CloseFont(fonts[id]);
+			fonts[id] = LoadFont(file, size);
+			if(fonts[id] && outline > 0)
+				TTF_SetFontOutline(fonts[id], outline);
+		}
+		else if(op == DrawTraceOp_GetTexture)
+		{
+			TextureType type = (TextureType)reader.U8();
+			String reference = TraceString(strings, reader.U32());
+			Uint32 id = reader.U32();
+			SDL_Texture* texture = GetTexture(type, reference);
+			if(id)
+				textures[id] = texture;
+		}
+		else if(op == DrawTraceOp_GetTextureFileReference)
+		{
+			String reference = TraceString(strings, reader.U32());
+			Uint32 id = reader.U32();
+			SDL_Texture* texture = GetTextureFileReference(reference);
+			if(id)
+				textures[id] = texture;
+		}
+		else if(op == DrawTraceOp_SpriteSourceRect)
+			SetSpriteSourceRect(TraceString(strings, reader.U32()), &source);
+		else if(op == DrawTraceOp_AnimationSourceRect)
+		{
+			String reference = TraceString(strings, reader.U32());
+			SetAnimationSourceRect(reference, reader.I32(), &source);
+		}
+		else if(op == DrawTraceOp_RenderText || op == DrawTraceOp_RenderOutlinedText)
+		{
+			String message = TraceString(strings, reader.U32());
+			SDL_Color color = reader.Color();
+			SDL_Color outlineColor = op == DrawTraceOp_RenderOutlinedText ? reader.Color() : color;
+			TTF_Font* font = fonts[reader.U32()];
+			TTF_Font* outlineFont = op == DrawTraceOp_RenderOutlinedText ? fonts[reader.U32()] : nullptr;
+			Uint32 id = reader.U32();
+
+			SDL_Texture* texture = nullptr;
+			if(font && (op == DrawTraceOp_RenderText || outlineFont))
+			{
+				texture = op == DrawTraceOp_RenderText ? RenderText(message, color, font, renderer) :
+							RenderOutlinedText(message, color, outlineColor, font, outlineFont, renderer);
+			}
+
+			if(textTextures[id])
+				SDL_DestroyTexture(textTextures[id]);
+			textTextures[id] = texture;
+			if(id)
+				textures[id] = texture;
+		}
+		else if(op == DrawTraceOp_BindTexture)
+		{
+			Uint32 id = reader.U32();
+			Uint8 binding = reader.U8();
+			SDL_Texture* texture = nullptr;
+
+			if(binding == DrawTraceBinding_FileReference)
+			{
+				String reference = TraceString(strings, reader.U32());
+				texture = GetTextureFileReference(reference);
+				if(!texture)
+					logError(std::cout, "ReplayDrawTrace: texture " + reference + " is not loaded");
+			}
+			else
+			{
+				Uint32 format = reader.U32();
+				int access = reader.I32();
+				int w = reader.I32();
+				int h = reader.I32();
+
+				//the pixels were never recorded, a blank texture of the same size costs the same to draw
+				texture = SDL_CreateTexture(renderer, format, access, w, h);
+				if(texture)
+				{
+					SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+					standInTextures.push_back(texture);
+				}
+				else
+					logSDLError(std::cout, "ReplayDrawTrace");
+			}
+
+			textures[id] = texture;
+		}
+		else if(op == DrawTraceOp_DrawTexture || op == DrawTraceOp_CopyTexture)
+		{
+			Uint32 id = reader.U32();
+			SDL_Texture* texture = FindBoundTexture(textures, id);
+
+			int x = 0, y = 0;
+			bool hasSource = false, hasDestination = false;
+			if(op == DrawTraceOp_DrawTexture)
+			{
+				x = reader.I32();
+				y = reader.I32();
+			}
+			else
+			{
+				hasSource = reader.Rect(&source);
+				hasDestination = reader.Rect(&destination);
+			}
+
+			//skipping the draw would leave its cost out of the frame times
+			if(id && !texture)
+			{
+				logError(std::cout, "ReplayDrawTrace: texture id " + IntToString((int)id) + " is not bound in " + fileName);
+				unbound = true;
+				break;
+			}
+
+			if(!texture)
+				continue;
+
+			if(op == DrawTraceOp_DrawTexture)
+				DrawTextureToRenderer(texture, renderer, x, y);
+			else
+				SDL_RenderCopy(renderer, texture, hasSource ? &source : NULL, hasDestination ? &destination : NULL);
+		}
+		else
+		{
+			logError(std::cout, "ReplayDrawTrace: unknown op " + IntToString(op) + " in " + fileName);
+			reader.failed = true;
+		}
+	}
+
+	for(std::map<Uint32, SDL_Texture*>::iterator it = textTextures.begin(); it != textTextures.end(); it++)
+		if(it->second)
+			SDL_DestroyTexture(it->second);
+
+	for(size_t i = 0; i < standInTextures.size(); i++)
+		SDL_DestroyTexture(standInTextures[i]);
+
+	for(std::map<Uint32, TTF_Font*>::iterator it = fonts.begin(); it != fonts.end(); it++)
+		if(it->second)
+			TTF_CloseFont(it->second);
+
+	if(reader.failed)
+		logError(std::cout, "ReplayDrawTrace: " + fileName + " ends early, replayed " + IntToString((int)frameTimes.size()) + " frames");
+
+	return !unbound;
+}
@@ -0,0 +1,87 @@
+#ifndef DRAWTRACE_H
+#define DRAWTRACE_H
+
+#include "StringUtil.h"
+#include "Textures.h"
+#include "SDLUtil.h"
+
+/**
+*    DrawTrace.h
+*
+*	This file has the functions used to record what each frame asks of the texture
+*	registry and the renderer, and to replay a recording against any renderer. A trace is
+*	a compact binary log of texture lookups, source rect lookups, text renders, font loads
+*	and draw calls with a marker at the end of every frame. tools/DrawTraceReplay replays
+*	a trace against the software renderer and reports frame time percentiles, so changes
+*	can be measured against a captured session with the same work every run.
+*
+*	Recording costs one flag check per call while it is off.
+*
+*		StartDrawTraceRecording("session.dtrace");
+*		while(running)
+*		{
+*			//update and draw
+*			SDL_RenderPresent(renderer);
+*			RecordDrawTraceFrame();
+*		}
+*		StopDrawTraceRecording();
+*/
+
+extern bool drawTraceRecording;
+
+/**
+*	Return whether calls are being recorded
+*/
+inline bool IsDrawTraceRecording()
+{
+	return drawTraceRecording;
+}
+
+/**
+*	Start recording to a file, replacing it. Fonts from LoadFont that are already open are
+*	unknown to the trace, so start recording before loading them. Cached fonts from GetFont
+*	are added to the trace the first time they are asked for while recording.
+*
+* @param fileName The path and name of the trace file
+* @return bool True if recording started; false if the file could not be opened
+*/
+bool StartDrawTraceRecording(const String& fileName);
+
+/**
+*	Stop recording and close the trace file
+*/
+void StopDrawTraceRecording();
+
+/**
+*	Mark the end of a frame and write the frame's calls to the trace file
+*/
+void RecordDrawTraceFrame();
+
+//Called by the functions being recorded. Only call these while IsDrawTraceRecording().
+void TraceLoadFont(const String& file, int fontSize, int outline, TTF_Font* font);
+void TraceGetFont(const String& file, int fontSize, int outline, TTF_Font* font);
+void TraceGetTexture(TextureType type, const String& reference, SDL_Texture* texture);
+void TraceGetTextureFileReference(const String& fileReference, SDL_Texture* texture);
+void TraceSpriteSourceRect(const String& spriteReference);
+void TraceAnimationSourceRect(const String& animationReference, int frame);
+void TraceRenderText(const String& message, SDL_Color color, TTF_Font* font, SDL_Texture* texture);
+void TraceRenderOutlinedText(const String& message, SDL_Color color, SDL_Color outlineColor,
+								TTF_Font* font, TTF_Font* outlineFont, SDL_Texture* texture);
+void TraceDrawTexture(SDL_Texture* texture, int x, int y);
+void TraceCopyTexture(SDL_Texture* texture, const SDL_Rect* source, const SDL_Rect* destination);
+
+/**
+*	Replay a trace. The textures the trace looks up must already be loaded with
+*	InitializeTextures. Textures that were not loaded from a file are replaced by blank
+*	textures of the same size. Text textures, stand in textures and fonts created by the
+*	trace are freed at the end. Replay stops at a draw whose texture could not be found
+*	rather than leaving the draw out of the frame times.
+*
+* @param fileName The path and name of the trace file
+* @param renderer The renderer to draw too
+* @param frameTimes Filled with the time of every replayed frame in milliseconds
+* @return bool True if the trace was replayed; false if it could not be read or a drawn texture could not be found
+*/
+bool ReplayDrawTrace(const String& fileName, SDL_Renderer* renderer, std::vector<double>& frameTimes);
+
+#endif //DRAWTRACE_H
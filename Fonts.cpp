@@ -0,0 +1,202 @@
+#include "stdafx.h"
+
+#include "Fonts.h"
+#include "DrawTrace.h"
+#include "Trace.h"
+#include "Archive.h"
+
+#include <map>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#endif
+
+/**
+*    Fonts.cpp
+*
+*	This file has the shared font bytes and the cached fonts opened from them. SDL_ttf
+*	reads glyphs from the bytes while a font is open, so the bytes are only released by
+*	ShutdownFonts after every cached font is closed.
+*/
+
+struct FontFile
+{
+	const Uint8* data;
+	int size;
+	bool archived;
+
+	#ifdef _WIN32
+		HANDLE file;
+		HANDLE mapping;
+	#else
+		std::vector<Uint8> bytes;
+	#endif
+};
+
+std::map<String, FontFile*> fontFiles;
+
+//fonts by file and then by size and outline, so a lookup never builds a key string
+std::map<String, std::map<Sint64, TTF_Font*> > fontReferences;
+
+static Sint64 FontSizeKey(int fontSize, int outline)
+{
+	return ((Sint64)fontSize << 32) | (Uint32)outline;
+}
+
+/**
+*	Use the archive's copy of the file if it has one. Otherwise map the whole file on
+*	Windows, or read it through RWops so Android assets work.
+*/
+static FontFile* LoadFontFile(const String& file)
+{
+	TRACE_SCOPE_ASSET("LoadFontFile", file);
+
+	FontFile* fontFile = new FontFile();
+	fontFile->size = 0;
+
+	//a packed font is used in place, it stays mapped with the archive
+	fontFile->data = GetArchivedAsset(file, &fontFile->size);
+	fontFile->archived = fontFile->data != nullptr;
+
+	#ifdef _WIN32
+		fontFile->mapping = nullptr;
+		fontFile->file = INVALID_HANDLE_VALUE;
+	#endif
+
+	if(fontFile->archived)
+		return fontFile;
+
+	#ifdef _WIN32
+		fontFile->file = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		LARGE_INTEGER size;
+		if(fontFile->file != INVALID_HANDLE_VALUE && GetFileSizeEx(fontFile->file, &size) && size.QuadPart > 0 && size.QuadPart < 0x7FFFFFFF)
+		{
+			fontFile->mapping = CreateFileMappingA(fontFile->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if(fontFile->mapping)
+			{
+				fontFile->data = (const Uint8*)MapViewOfFile(fontFile->mapping, FILE_MAP_READ, 0, 0, 0);
+				fontFile->size = (int)size.QuadPart;
+			}
+		}
+	#else
+		SDL_RWops* rw = SDL_RWFromFile(file.c_str(), "rb");
+		if(rw)
+		{
+			Sint64 size = SDL_RWsize(rw);
+			if(size > 0 && size < 0x7FFFFFFF)
+			{
+				fontFile->bytes.resize((size_t)size);
+				if(SDL_RWread(rw, &fontFile->bytes[0], (size_t)size, 1) == 1)
+				{
+					fontFile->data = &fontFile->bytes[0];
+					fontFile->size = (int)size;
+				}
+			}
+			SDL_RWclose(rw);
+		}
+	#endif
+
+	if(!fontFile->data)
+		logError(std::cout, "LoadFontFile: error opening: " + file);
+
+	TRACE_BYTES(fontFile->size);
+
+	return fontFile;
+}
+
+static void FreeFontFile(FontFile* fontFile)
+{
+	#ifdef _WIN32
+		if(fontFile->data && !fontFile->archived)
+			UnmapViewOfFile(fontFile->data);
+		if(fontFile->mapping)
+			CloseHandle(fontFile->mapping);
+		if(fontFile->file != INVALID_HANDLE_VALUE)
+			CloseHandle(fontFile->file);
+	#endif
+
+	delete fontFile;
+}
+
+static FontFile* GetFontFile(const String& file)
+{
+	std::map<String, FontFile*>::iterator it = fontFiles.find(file);
+	if(it != fontFiles.end())
+		return it->second;
+
+	//a file that failed to load is not kept, so it is read again once it exists
+	FontFile* fontFile = LoadFontFile(file);
+	if(!fontFile->data)
+	{
+		FreeFontFile(fontFile);
+		return nullptr;
+	}
+
+	fontFiles[file] = fontFile;
+
+	return fontFile;
+}
+
+TTF_Font* OpenSharedFont(const String& file, int fontSize)
+{
+	FontFile* fontFile = GetFontFile(file);
+	if(!fontFile)
+		return nullptr;
+
+	//the RWops only wraps the shared bytes, closing it with the font leaves them alone
+	return TTF_OpenFontRW(SDL_RWFromConstMem(fontFile->data, fontFile->size), 1, fontSize);
+}
+
+TTF_Font* GetFont(const String& file, int fontSize, int outline)
+{
+	Sint64 sizeKey = FontSizeKey(fontSize, outline);
+
+	std::map<String, std::map<Sint64, TTF_Font*> >::iterator sizes = fontReferences.find(file);
+	if(sizes != fontReferences.end())
+	{
+		std::map<Sint64, TTF_Font*>::iterator it = sizes->second.find(sizeKey);
+		if(it != sizes->second.end())
+		{
+			if(IsDrawTraceRecording())
+				TraceGetFont(file, fontSize, outline, it->second);
+
+			return it->second;
+		}
+	}
+
+	TRACE_SCOPE_ASSET("GetFont", file);
+
+	TTF_Font* font = OpenSharedFont(file, fontSize);
+
+	if(font == nullptr)
+	{
+		logSDLError(std::cout, "GetFont");
+		return nullptr;
+	}
+
+	if(outline > 0)
+		TTF_SetFontOutline(font, outline);
+
+	fontReferences[file][sizeKey] = font;
+
+	if(IsDrawTraceRecording())
+		TraceLoadFont(file, fontSize, outline, font);
+
+	return font;
+}
+
+void ShutdownFonts()
+{
+	for(std::map<String, std::map<Sint64, TTF_Font*> >::iterator sizes = fontReferences.begin(); sizes != fontReferences.end(); sizes++)
+		for(std::map<Sint64, TTF_Font*>::iterator it = sizes->second.begin(); it != sizes->second.end(); it++)
+			TTF_CloseFont(it->second);
+
+	for(std::map<String, FontFile*>::iterator it = fontFiles.begin(); it != fontFiles.end(); it++)
+		FreeFontFile(it->second);
+
+	fontReferences.clear();
+	fontFiles.clear();
+}
@@ -0,0 +1,49 @@
+#ifndef FONTS_H
+#define FONTS_H
+
+#include "StringUtil.h"
+#include "SDLUtil.h"
+
+/**
+*    Fonts.h
+*
+*	This file has the font cache. Each font file is read once, memory mapped on Windows,
+*	and every size and outline of it is opened from those shared bytes. Fonts are cached
+*	by file, size and outline so asking for the same font again returns the open one.
+*	A font file that fails to load is not cached, so a later call tries it again.
+*
+*	Fonts opened with LoadFont or OpenSharedFont read from the same shared bytes, so the
+*	caller must close them with TTF_CloseFont before ShutdownFonts releases the bytes.
+*
+*		TTF_Font* font = GetFont("font/main.ttf", 24);
+*		TTF_Font* outlineFont = GetFont("font/main.ttf", 24, 2);
+*/
+
+/**
+*	Return the cached font for the file, size and outline, opening it the first time.
+*	The cache owns the font so do not close it.
+*
+* @param file The file name of the font
+* @param fontSize The size of the font to use
+* @param outline The outline width in pixels, 0 for none
+* @return TTF_Font* The font, nullptr if it could not be opened
+*/
+TTF_Font* GetFont(const String& file, int fontSize, int outline = 0);
+
+/**
+*	Open a new font from the file's shared bytes. The caller owns the font and must close
+*	it with TTF_CloseFont before ShutdownFonts is called.
+*
+* @param file The file name of the font
+* @param fontSize The size of the font to use
+* @return TTF_Font* The font, nullptr if it could not be opened
+*/
+TTF_Font* OpenSharedFont(const String& file, int fontSize);
+
+/**
+*	Close every cached font and release the shared font bytes. Call once before shutting down the game,
+*	after every font from LoadFont or OpenSharedFont is closed since they still read the shared bytes.
+*/
+void ShutdownFonts();
+
+#endif //FONTS_H
@@ -0,0 +1,186 @@
+#include "stdafx.h"
+
+#include "PaletteSwap.h"
+#include "SimdKernels.h"
+
+/**
+*    PaletteSwap.cpp
+*
+*	The vector kernels compare a block of pixels, with alpha masked off, against every
+*	source color and select the matching target with the compare mask. The first matching
+*	swap wins, the same as the scalar loop, so both give the same bytes.
+*/
+
+void RemapRowARGBScalar(Uint32* pixels, int count, const Uint32* sources, const Uint32* targets, int swapCount)
+{
+	for(int i = 0; i < count; i++)
+	{
+		Uint32 color = pixels[i] & 0x00ffffff;
+
+		for(int s = 0; s < swapCount; s++)
+		{
+			if(color == sources[s])
+			{
+				pixels[i] = (pixels[i] & 0xff000000) | targets[s];
+				break;
+			}
+		}
+	}
+}
+
+#ifdef SIMD_SSE2
+
+/**
+*	Four pixels per compare. SSE2 has no select so the target is ORed in under the hit
+*	mask and unmatched lanes get their own color back the same way at the end.
+*/
+static void RemapRowARGBSSE2(Uint32* pixels, int count, const Uint32* sources, const Uint32* targets, int swapCount)
+{
+	const __m128i colorMask = _mm_set1_epi32(0x00ffffff);
+	int i = 0;
+
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128i p = _mm_loadu_si128((const __m128i*)(pixels + i));
+		__m128i color = _mm_and_si128(p, colorMask);
+		__m128i result = _mm_andnot_si128(colorMask, p);
+		__m128i matched = _mm_setzero_si128();
+
+		for(int s = 0; s < swapCount; s++)
+		{
+			//only lanes no earlier swap matched
+			__m128i hit = _mm_andnot_si128(matched, _mm_cmpeq_epi32(color, _mm_set1_epi32((int)sources[s])));
+			result = _mm_or_si128(result, _mm_and_si128(hit, _mm_set1_epi32((int)targets[s])));
+			matched = _mm_or_si128(matched, hit);
+		}
+
+		result = _mm_or_si128(result, _mm_andnot_si128(matched, color));
+		_mm_storeu_si128((__m128i*)(pixels + i), result);
+	}
+
+	RemapRowARGBScalar(pixels + i, count - i, sources, targets, swapCount);
+}
+
+#endif //SIMD_SSE2
+
+#ifdef SIMD_AVX2
+
+/**
+*	The SSE2 kernel widened to eight pixels, for sprite sheets wide enough that the
+*	longer rows pay for the wider compares
+*/
+SIMD_AVX2_TARGET static void RemapRowARGBAVX2(Uint32* pixels, int count, const Uint32* sources, const Uint32* targets, int swapCount)
+{
+	const __m256i colorMask = _mm256_set1_epi32(0x00ffffff);
+	int i = 0;
+
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i p = _mm256_loadu_si256((const __m256i*)(pixels + i));
+		__m256i color = _mm256_and_si256(p, colorMask);
+		__m256i result = _mm256_andnot_si256(colorMask, p);
+		__m256i matched = _mm256_setzero_si256();
+
+		for(int s = 0; s < swapCount; s++)
+		{
+			__m256i hit = _mm256_andnot_si256(matched, _mm256_cmpeq_epi32(color, _mm256_set1_epi32((int)sources[s])));
+			result = _mm256_or_si256(result, _mm256_and_si256(hit, _mm256_set1_epi32((int)targets[s])));
+			matched = _mm256_or_si256(matched, hit);
+		}
+
+		result = _mm256_or_si256(result, _mm256_andnot_si256(matched, color));
+		_mm256_storeu_si256((__m256i*)(pixels + i), result);
+	}
+
+	RemapRowARGBScalar(pixels + i, count - i, sources, targets, swapCount);
+}
+
+#endif //SIMD_AVX2
+
+#ifdef SIMD_NEON
+
+/**
+*	Four pixels per compare. vbic clears the lanes an earlier swap already took in one
+*	instruction, where SSE2 needs an and-not with the operands the other way round.
+*/
+static void RemapRowARGBNEON(Uint32* pixels, int count, const Uint32* sources, const Uint32* targets, int swapCount)
+{
+	const uint32x4_t colorMask = vdupq_n_u32(0x00ffffff);
+	int i = 0;
+
+	for(; i + 4 <= count; i += 4)
+	{
+		uint32x4_t p = vld1q_u32(pixels + i);
+		uint32x4_t color = vandq_u32(p, colorMask);
+		uint32x4_t result = vbicq_u32(p, colorMask);
+		uint32x4_t matched = vdupq_n_u32(0);
+
+		for(int s = 0; s < swapCount; s++)
+		{
+			uint32x4_t hit = vbicq_u32(vceqq_u32(color, vdupq_n_u32(sources[s])), matched);
+			result = vorrq_u32(result, vandq_u32(hit, vdupq_n_u32(targets[s])));
+			matched = vorrq_u32(matched, hit);
+		}
+
+		result = vorrq_u32(result, vbicq_u32(color, matched));
+		vst1q_u32(pixels + i, result);
+	}
+
+	RemapRowARGBScalar(pixels + i, count - i, sources, targets, swapCount);
+}
+
+#endif //SIMD_NEON
+
+typedef void (*RemapRowFunction)(Uint32* pixels, int count, const Uint32* sources, const Uint32* targets, int swapCount);
+
+static RemapRowFunction SelectRemapRow()
+{
+	#if defined(SIMD_AVX2)
+		if(SDL_HasAVX2())
+			return RemapRowARGBAVX2;
+	#endif
+
+	#if defined(SIMD_SSE2)
+		return RemapRowARGBSSE2;
+	#elif defined(SIMD_NEON)
+		return RemapRowARGBNEON;
+	#else
+		return RemapRowARGBScalar;
+	#endif
+}
+
+void RemapRowARGB(Uint32* pixels, int count, const Uint32* sources, const Uint32* targets, int swapCount)
+{
+	static const RemapRowFunction remapRow = SelectRemapRow();
+
+	remapRow(pixels, count, sources, targets, swapCount);
+}
+
+bool RemapSurfaceColorsARGB(SDL_Surface* surface, const std::vector<PaletteSwap>& swaps)
+{
+	if(!surface || surface->format->format != SDL_PIXELFORMAT_ARGB8888)
+		return false;
+
+	if(swaps.empty())
+		return true;
+
+	std::vector<Uint32> sources(swaps.size());
+	std::vector<Uint32> targets(swaps.size());
+
+	for(size_t i = 0; i < swaps.size(); i++)
+	{
+		sources[i] = ((Uint32)swaps[i].source.r << 16) | ((Uint32)swaps[i].source.g << 8) | swaps[i].source.b;
+		targets[i] = ((Uint32)swaps[i].target.r << 16) | ((Uint32)swaps[i].target.g << 8) | swaps[i].target.b;
+	}
+
+	if(SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+
+	for(int y = 0; y < surface->h; y++)
+		RemapRowARGB((Uint32*)((Uint8*)surface->pixels + y * surface->pitch), surface->w, &sources[0], &targets[0], (int)swaps.size());
+
+	if(SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+
+	return true;
+}
@@ -0,0 +1,57 @@
+#ifndef PALETTESWAP_H
+#define PALETTESWAP_H
+
+/**
+*    PaletteSwap.h
+*
+*	This file has the color remap used to make recolored variants of an image. Every
+*	pixel whose red, green and blue match a swap's source color takes the swap's target
+*	color and keeps its own alpha, so antialiased edges recolor with the rest of the
+*	shape. Swaps are looked up against the original color, so swapping red to blue and
+*	blue to green does not turn red into green. Rows are remapped four or eight pixels at
+*	a time with SSE2, AVX2 or NEON when available and one at a time otherwise.
+*/
+
+/**
+*	One color to replace and its replacement. The alpha of both colors is ignored.
+*/
+struct PaletteSwap
+{
+	SDL_Color source;
+	SDL_Color target;
+};
+
+/**
+* Remap the colors of an ARGB8888 surface in place
+*
+* @param surface The surface to remap
+* @param swaps The colors to replace
+* @return true if the surface was remapped; false if it is not ARGB8888
+*/
+bool RemapSurfaceColorsARGB(SDL_Surface* surface, const std::vector<PaletteSwap>& swaps);
+
+/**
+* Remap a row of ARGB8888 pixels with the fastest kernel the CPU supports
+*
+* @param pixels The pixels to remap
+* @param count The number of pixels in the row
+* @param sources The source colors as 0x00RRGGBB
+* @param targets The target colors as 0x00RRGGBB
+* @param swapCount The number of sources and targets
+*/
+void RemapRowARGB(Uint32* pixels, int count, const Uint32* sources, const Uint32* targets, int swapCount);
+
+/**
+* Remap a row of ARGB8888 pixels one pixel at a time, stopping at the first swap that
+* matches each pixel. The vector kernels finish the pixels left over past their last
+* full block with it.
+*
+* @param pixels The pixels to remap
+* @param count The number of pixels in the row
+* @param sources The source colors as 0x00RRGGBB
+* @param targets The target colors as 0x00RRGGBB
+* @param swapCount The number of sources and targets
+*/
+void RemapRowARGBScalar(Uint32* pixels, int count, const Uint32* sources, const Uint32* targets, int swapCount);
+
+#endif //PALETTESWAP_H
@@ -0,0 +1,365 @@
+#include "stdafx.h"
+
+#include "Qoi.h"
+#include "Trace.h"
+#include "Archive.h"
+
+#include <string.h>
+
+/**
+*    Qoi.cpp
+*
+*	Each pixel is a run of the previous pixel, an index into the 64 most recently seen
+*	pixels, a small difference from the previous pixel or the pixel itself. The decoder
+*	writes RGBA bytes in the order the surface from CreateSurface stores them, so there
+*	is no conversion before the texture upload.
+*/
+
+const Uint8 QoiOpIndex = 0x00;
+const Uint8 QoiOpDiff = 0x40;
+const Uint8 QoiOpLuma = 0x80;
+const Uint8 QoiOpRun = 0xc0;
+const Uint8 QoiOpRgb = 0xfe;
+const Uint8 QoiOpRgba = 0xff;
+const Uint8 QoiMask = 0xc0;
+
+const int QoiHeaderSize = 14;
+const int QoiPaddingSize = 8;
+const Uint8 QoiPadding[QoiPaddingSize] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+//larger images are rejected before allocating, as the reference implementation does
+const Uint32 QoiMaxPixels = 400000000;
+
+struct QoiPixel
+{
+	Uint8 r, g, b, a;
+};
+
+static inline int QoiHash(const QoiPixel& p)
+{
+	return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) & 63;
+}
+
+static inline bool SamePixel(const QoiPixel& a, const QoiPixel& b)
+{
+	return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static Uint32 ReadBigEndian32(const Uint8* p)
+{
+	return ((Uint32)p[0] << 24) | ((Uint32)p[1] << 16) | ((Uint32)p[2] << 8) | p[3];
+}
+
+static void WriteBigEndian32(std::vector<Uint8>& data, Uint32 value)
+{
+	data.push_back((Uint8)(value >> 24));
+	data.push_back((Uint8)(value >> 16));
+	data.push_back((Uint8)(value >> 8));
+	data.push_back((Uint8)value);
+}
+
+bool IsQoiFile(const String& fileName)
+{
+	return fileName.length() >= 4 && fileName.compare(fileName.length() - 4, 4, ".qoi") == 0;
+}
+
+SDL_Surface* LoadPreferredImageSurface(const String& fileName)
+{
+	if(IsQoiFile(fileName) || fileName.length() < 4)
+		return LoadSurfaceFromFile(fileName);
+
+	String qoiFileName = fileName.substr(0, fileName.length() - 4) + ".qoi";
+
+	//the archive index answers for packed files without opening anything
+	int archivedSize;
+	if(GetArchivedAsset(qoiFileName, &archivedSize))
+		return LoadQoiSurface(qoiFileName);
+	if(GetArchivedAsset(fileName, &archivedSize))
+		return LoadSurfaceFromFile(fileName);
+
+	//on disk the open that finds the QOI file is the one it is read through,
+	//SDL_RWFromFile also finds Android assets
+	SDL_RWops* rw = SDL_RWFromFile(qoiFileName.c_str(), "rb");
+	if(rw)
+		return LoadQoiSurface(rw, qoiFileName);
+
+	return LoadSurfaceFromFile(fileName);
+}
+
+SDL_Surface* DecodeQoi(const Uint8* data, int size)
+{
+	if(!data || size < QoiHeaderSize + QoiPaddingSize || memcmp(data, "qoif", 4) != 0)
+	{
+		logError(std::cout, "DecodeQoi: not a QOI image");
+		return nullptr;
+	}
+
+	Uint32 width = ReadBigEndian32(data + 4);
+	Uint32 height = ReadBigEndian32(data + 8);
+	Uint8 channels = data[12];
+
+	if(width == 0 || height == 0 || (channels != 3 && channels != 4) || height >= QoiMaxPixels / width)
+	{
+		logError(std::cout, "DecodeQoi: invalid QOI header");
+		return nullptr;
+	}
+
+	SDL_Surface* surface = CreateSurface((int)width, (int)height);
+	if(!surface)
+		return nullptr;
+
+	QoiPixel index[64];
+	memset(index, 0, sizeof(index));
+
+	QoiPixel p = {0, 0, 0, 255};
+	int run = 0;
+	int position = QoiHeaderSize;
+	int end = size - QoiPaddingSize;
+
+	for(Uint32 y = 0; y < height; y++)
+	{
+		QoiPixel* row = (QoiPixel*)((Uint8*)surface->pixels + y * surface->pitch);
+
+		for(Uint32 x = 0; x < width; x++)
+		{
+			if(run > 0)
+				run--;
+			else if(position < end)
+			{
+				Uint8 b1 = data[position++];
+
+				if(b1 == QoiOpRgb)
+				{
+					if(position + 3 > size)
+						break;
+					p.r = data[position];
+					p.g = data[position + 1];
+					p.b = data[position + 2];
+					position += 3;
+				}
+				else if(b1 == QoiOpRgba)
+				{
+					if(position + 4 > size)
+						break;
+					p.r = data[position];
+					p.g = data[position + 1];
+					p.b = data[position + 2];
+					p.a = data[position + 3];
+					position += 4;
+				}
+				else if((b1 & QoiMask) == QoiOpIndex)
+					p = index[b1];
+				else if((b1 & QoiMask) == QoiOpDiff)
+				{
+					p.r += ((b1 >> 4) & 0x03) - 2;
+					p.g += ((b1 >> 2) & 0x03) - 2;
+					p.b += (b1 & 0x03) - 2;
+				}
+				else if((b1 & QoiMask) == QoiOpLuma)
+				{
+					if(position >= size)
+						break;
+					Uint8 b2 = data[position++];
+					int vg = (b1 & 0x3f) - 32;
+					p.r += vg - 8 + ((b2 >> 4) & 0x0f);
+					p.g += vg;
+					p.b += vg - 8 + (b2 & 0x0f);
+				}
+				else
+					run = b1 & 0x3f;
+
+				index[QoiHash(p)] = p;
+			}
+
+			row[x] = p;
+		}
+	}
+
+	return surface;
+}
+
+SDL_Surface* LoadQoiSurface(const String& file)
+{
+	//a packed image is decoded in place
+	int archivedSize;
+	const Uint8* archived = GetArchivedAsset(file, &archivedSize);
+	if(archived)
+	{
+		TRACE_SCOPE_ASSET("LoadQoiSurface", file);
+
+		SDL_Surface* surface = DecodeQoi(archived, archivedSize);
+		if(!surface)
+			logError(std::cout, "LoadQoiSurface: error decoding: " + file);
+		return surface;
+	}
+
+	SDL_RWops* rw = SDL_RWFromFile(file.c_str(), "rb");
+	if(!rw)
+	{
+		logError(std::cout, "LoadQoiSurface: error opening: " + file);
+		return nullptr;
+	}
+
+	return LoadQoiSurface(rw, file);
+}
+
+SDL_Surface* LoadQoiSurface(SDL_RWops* rw, const String& file)
+{
+	TRACE_SCOPE_ASSET("LoadQoiSurface", file);
+
+	std::vector<Uint8> data;
+	Sint64 size = SDL_RWsize(rw);
+	if(size > 0 && size < 0x7FFFFFFF)
+	{
+		data.resize((size_t)size);
+		if(SDL_RWread(rw, &data[0], (size_t)size, 1) != 1)
+			data.clear();
+	}
+	SDL_RWclose(rw);
+
+	if(data.empty())
+	{
+		logError(std::cout, "LoadQoiSurface: error reading: " + file);
+		return nullptr;
+	}
+
+	SDL_Surface* surface = DecodeQoi(&data[0], (int)data.size());
+	if(surface)
+		TRACE_BYTES(surface->pitch * surface->h);
+	else
+		logError(std::cout, "LoadQoiSurface: error decoding: " + file);
+
+	return surface;
+}
+
+bool EncodeQoi(SDL_Surface* surface, std::vector<Uint8>& data)
+{
+	data.clear();
+
+	if(!surface || surface->w <= 0 || surface->h <= 0)
+		return false;
+
+	//the same byte order CreateSurface uses
+	SDL_Surface* rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+	if(!rgba)
+	{
+		logSDLError(std::cout, "EncodeQoi");
+		return false;
+	}
+
+	data.reserve(QoiHeaderSize + rgba->w * rgba->h * 5 + QoiPaddingSize);
+	data.push_back('q');
+	data.push_back('o');
+	data.push_back('i');
+	data.push_back('f');
+	WriteBigEndian32(data, (Uint32)rgba->w);
+	WriteBigEndian32(data, (Uint32)rgba->h);
+	data.push_back(4);
+	data.push_back(0);
+
+	QoiPixel index[64];
+	memset(index, 0, sizeof(index));
+
+	QoiPixel previous = {0, 0, 0, 255};
+	int run = 0;
+	int pixelCount = rgba->w * rgba->h;
+	int pixel = 0;
+
+	for(int y = 0; y < rgba->h; y++)
+	{
+		const QoiPixel* row = (const QoiPixel*)((const Uint8*)rgba->pixels + y * rgba->pitch);
+
+		for(int x = 0; x < rgba->w; x++, pixel++)
+		{
+			const QoiPixel p = row[x];
+
+			if(SamePixel(p, previous))
+			{
+				run++;
+				if(run == 62 || pixel == pixelCount - 1)
+				{
+					data.push_back(QoiOpRun | (Uint8)(run - 1));
+					run = 0;
+				}
+				continue;
+			}
+
+			if(run > 0)
+			{
+				data.push_back(QoiOpRun | (Uint8)(run - 1));
+				run = 0;
+			}
+
+			int hash = QoiHash(p);
+
+			if(SamePixel(index[hash], p))
+				data.push_back(QoiOpIndex | (Uint8)hash);
+			else
+			{
+				index[hash] = p;
+
+				if(p.a == previous.a)
+				{
+					signed char vr = (signed char)(p.r - previous.r);
+					signed char vg = (signed char)(p.g - previous.g);
+					signed char vb = (signed char)(p.b - previous.b);
+					signed char vgr = (signed char)(vr - vg);
+					signed char vgb = (signed char)(vb - vg);
+
+					if(vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+						data.push_back(QoiOpDiff | (Uint8)((vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+					else if(vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8)
+					{
+						data.push_back(QoiOpLuma | (Uint8)(vg + 32));
+						data.push_back((Uint8)((vgr + 8) << 4 | (vgb + 8)));
+					}
+					else
+					{
+						data.push_back(QoiOpRgb);
+						data.push_back(p.r);
+						data.push_back(p.g);
+						data.push_back(p.b);
+					}
+				}
+				else
+				{
+					data.push_back(QoiOpRgba);
+					data.push_back(p.r);
+					data.push_back(p.g);
+					data.push_back(p.b);
+					data.push_back(p.a);
+				}
+			}
+
+			previous = p;
+		}
+	}
+
+	data.insert(data.end(), QoiPadding, QoiPadding + QoiPaddingSize);
+
+	SDL_FreeSurface(rgba);
+
+	return true;
+}
+
+bool SaveQoiSurface(SDL_Surface* surface, const String& file)
+{
+	std::vector<Uint8> data;
+	if(!EncodeQoi(surface, data))
+		return false;
+
+	SDL_RWops* rw = SDL_RWFromFile(file.c_str(), "wb");
+	if(!rw)
+	{
+		logError(std::cout, "SaveQoiSurface: error opening: " + file);
+		return false;
+	}
+
+	bool written = SDL_RWwrite(rw, &data[0], data.size(), 1) == 1;
+	SDL_RWclose(rw);
+
+	if(!written)
+		logError(std::cout, "SaveQoiSurface: error writing: " + file);
+
+	return written;
+}
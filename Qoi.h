@@ -0,0 +1,76 @@
+#ifndef QOI_H
+#define QOI_H
+
+#include "StringUtil.h"
+#include "SDLUtil.h"
+
+/**
+*    Qoi.h
+*
+*	This file has the functions used to read and write images in the QOI format
+*	(https://qoiformat.org). QOI is lossless like PNG but decodes several times faster,
+*	so converting the game's images with tools/PngToQoi shortens loading. LoadFile and
+*	AddFileReference pick up "sprites.qoi" in place of "sprites.png" when it exists, and
+*	LoadSurfaceFromFile and LoadTextureFromFile read any file ending in ".qoi".
+*/
+
+/**
+*	Return whether the file name ends in ".qoi"
+*/
+bool IsQoiFile(const String& fileName);
+
+/**
+*	Load the ".qoi" version of an image if there is one, otherwise the image itself.
+*	Packed images are found through the archive index without opening anything, and on
+*	disk the QOI file is read through the same open that found it.
+*
+* @param fileName The path and name of an image, such as "image/sprites.png"
+* @return SDL_Surface* The image, nullptr if neither file could be loaded
+*/
+SDL_Surface* LoadPreferredImageSurface(const String& fileName);
+
+/**
+*	Decode a QOI image straight into a 32 bit RGBA surface made by CreateSurface
+*
+* @param data The bytes of the QOI file
+* @param size The number of bytes
+* @return SDL_Surface* The image, nullptr if the data is not a valid QOI image
+*/
+SDL_Surface* DecodeQoi(const Uint8* data, int size);
+
+/**
+*	Read and decode a QOI file
+*
+* @param file The path and name of the file
+* @return SDL_Surface* The image, nullptr if it could not be read
+*/
+SDL_Surface* LoadQoiSurface(const String& file);
+
+/**
+*	Read and decode a QOI file that is already open
+*
+* @param rw The open file, closed before this returns
+* @param file The path and name of the file, used in errors and the trace
+* @return SDL_Surface* The image, nullptr if it could not be read
+*/
+SDL_Surface* LoadQoiSurface(SDL_RWops* rw, const String& file);
+
+/**
+*	Encode a surface as a QOI image with 4 channels
+*
+* @param surface The surface to encode, any format SDL can convert
+* @param data Filled with the bytes of the QOI file
+* @return bool True if the surface was encoded
+*/
+bool EncodeQoi(SDL_Surface* surface, std::vector<Uint8>& data);
+
+/**
+*	Encode a surface and write it to a QOI file
+*
+* @param surface The surface to save
+* @param file The path and name of the file, replaced if it exists
+* @return bool True if the file was written
+*/
+bool SaveQoiSurface(SDL_Surface* surface, const String& file);
+
+#endif //QOI_H
@@ -1,6 +1,13 @@
 #include "stdafx.h"
 
 #include "SDLUtil.h"
+#include "AllocationTracker.h"
+#include "Trace.h"
+#include "SurfaceBlend.h"
+#include "DrawTrace.h"
+#include "Fonts.h"
+#include "Qoi.h"
+#include "Archive.h"
 #include "SDL_image.h"
 #include "SDL_opengl.h"
 
@@ -40,7 +47,7 @@ SDL_Renderer* InitSDLRenderer(SDL_Window* window)
 		#endif
 		//SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
 		
-		SDL_RenderSetLogicalSize(renderer, 640, 360);
+		SDL_RenderSetLogicalSize(renderer, LogicalWidth, LogicalHeight);
 		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
 	}
 	if (renderer == nullptr)
@@ -54,10 +61,18 @@ SDL_Renderer* InitSDLRenderer(SDL_Window* window)
 
 SDL_Surface* LoadSurfaceFromFile(const String &file)
 {
-	SDL_Surface *surface = IMG_Load(file.c_str());
+	TRACE_SCOPE_ASSET("LoadSurfaceFromFile", file);
+
+	if(IsQoiFile(file))
+		return LoadQoiSurface(file);
+
+	//packed files are read from the archive, others from disk
+	SDL_Surface *surface = IMG_Load_RW(OpenAssetFile(file), 1);
 
 	if (surface == nullptr)
 		logSDLError(std::cout, "LoadSurfaceFromFile");
+	else
+		TRACE_BYTES(surface->pitch * surface->h);
 
 	return surface;
 }
@@ -86,23 +101,30 @@ SDL_Surface* CreateSurface(int width, int height)
 
 SDL_Texture* LoadTextureFromFile(const String &file, SDL_Renderer *renderer)
 {
+	TRACE_SCOPE_ASSET("LoadTextureFromFile", file);
+
 	SDL_Texture *texture = nullptr;
 	SDL_Surface *loadedImage = nullptr;
 
-	//android
-	#if defined(__ANDROID__)
-		SDL_RWops *f = SDL_RWFromFile(file.c_str(), "rb");
+	if(IsQoiFile(file))
+		loadedImage = LoadQoiSurface(file);
+	else
+	{
+		//packed files are read from the archive, others from disk
+		SDL_RWops *f = OpenAssetFile(file);
 		loadedImage = IMG_Load_RW(f , 1);
 
-		if(f > 0)
-			__android_log_write(ANDROID_LOG_INFO, "Chain Drop", "File Loaded");
-	#elif defined(_WIN32)
-		loadedImage = IMG_Load(file.c_str());
-	#endif
+		//android
+		#if defined(__ANDROID__)
+			if(f != nullptr)
+				__android_log_write(ANDROID_LOG_INFO, "Chain Drop", "File Loaded");
+		#endif
+	}
 
 	//If the loading went ok, convert to texture and return the texture
 	if (loadedImage != nullptr)
 	{
+		TRACE_BYTES(loadedImage->pitch * loadedImage->h);
 		texture = SDL_CreateTextureFromSurface(renderer, loadedImage);
 		SDL_FreeSurface(loadedImage);
 		//Make sure converting went ok too
@@ -115,37 +137,63 @@ SDL_Texture* LoadTextureFromFile(const String &file, SDL_Renderer *renderer)
 	return texture;
 }
 
+bool GetMaxTextureSize(SDL_Renderer *renderer, int* width, int* height)
+{
+	SDL_RendererInfo info;
+
+	if (SDL_GetRendererInfo(renderer, &info) != 0)
+	{
+		logSDLError(std::cout, "GetMaxTextureSize");
+		return false;
+	}
+
+	//some drivers report 0 when they have no limit
+	if (info.max_texture_width <= 0 || info.max_texture_height <= 0)
+		return false;
+
+	*width = info.max_texture_width;
+	*height = info.max_texture_height;
+
+	return true;
+}
+
 TTF_Font* LoadFont(const String &file, int fontSize)
 {
-	TTF_Font *font = nullptr;
+	TRACE_SCOPE_ASSET("LoadFont", file);
 
-	#if defined(__ANDROID__)
-		SDL_RWops *f = SDL_RWFromFile(file.c_str(), "rb");
-		font = TTF_OpenFontRW(f, 1, fontSize);
-	#elif defined(_WIN32)
-		font = TTF_OpenFont(file.c_str(), fontSize);
-	#endif
+	//opened from the font manager's copy of the file so every size shares one
+	TTF_Font *font = OpenSharedFont(file, fontSize);
 
 	if (font == nullptr)
 		logSDLError(std::cout, "OpenFont");
+	else if (IsDrawTraceRecording())
+		TraceLoadFont(file, fontSize, 0, font);
 
 	return font;
 }
 
 SDL_Texture* RenderText(const String& message, SDL_Color color, TTF_Font *font, SDL_Renderer* renderer)
 {
+	ALLOCATION_PHASE("text");
+	TRACE_SCOPE_ASSET("RenderText", message);
+
 	//Render the message to an SDL_Surface and create a texture to return
 	SDL_Surface *surface = nullptr;
 	surface = TTF_RenderText_Blended(font, message.c_str(), color);
+	if(surface)
+		TRACE_BYTES(surface->pitch * surface->h);
 	SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
 	
 	//Clean up unneeded stuff
 	SDL_FreeSurface(surface);
+
+	if(IsDrawTraceRecording())
+		TraceRenderText(message, color, font, texture);
  
 	return texture;
 }
 
-SDL_Texture* RenderOutlinedText(const String& message, SDL_Color color, SDL_Color outlineColor, TTF_Font *font, TTF_Font *outlineFont, SDL_Renderer* renderer)
+SDL_Surface* RenderOutlinedTextSurface(const String& message, SDL_Color color, SDL_Color outlineColor, TTF_Font *font, TTF_Font *outlineFont)
 {
 	//Render the message to an SDL_Surface and create a texture to return
 	//SDL_Surface *bgSurface = TTF_RenderText_Blended(outlineFont, message.c_str(), outlineColor);
@@ -153,18 +201,43 @@ SDL_Texture* RenderOutlinedText(const String& message, SDL_Color color, SDL_Colo
 
 	SDL_Surface *bgSurface = TTF_RenderText_Blended(outlineFont, message.c_str(), outlineColor);
 	SDL_Surface *fgSurface = TTF_RenderText_Blended(font, message.c_str(), color);
+
+	//SDL_ttf gives no surface for an empty message or on failure
+	if(!fgSurface || !bgSurface)
+	{
+		SDL_FreeSurface(fgSurface);
+		SDL_FreeSurface(bgSurface);
+		return nullptr;
+	}
 	
 	SDL_Rect r = {TTF_GetFontOutline(outlineFont), TTF_GetFontOutline(outlineFont), fgSurface->w, fgSurface->h};
 
-	/* blit text onto its outline */
-	SDL_SetSurfaceBlendMode(fgSurface, SDL_BLENDMODE_BLEND);
-	SDL_BlitSurface(fgSurface, NULL, bgSurface, &r);
+	/* blend text onto its outline, falling back to a blit for other pixel formats */
+	if(!BlendSurfaceARGB(fgSurface, bgSurface, r.x, r.y))
+	{
+		SDL_SetSurfaceBlendMode(fgSurface, SDL_BLENDMODE_BLEND);
+		SDL_BlitSurface(fgSurface, NULL, bgSurface, &r);
+	}
 
-	SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, bgSurface);
- 
 	//Clean up unneeded stuff
 	SDL_FreeSurface(fgSurface); 
-	SDL_FreeSurface(bgSurface);
+
+	return bgSurface;
+}
+
+SDL_Texture* RenderOutlinedText(const String& message, SDL_Color color, SDL_Color outlineColor, TTF_Font *font, TTF_Font *outlineFont, SDL_Renderer* renderer)
+{
+	ALLOCATION_PHASE("text");
+	TRACE_SCOPE_ASSET("RenderOutlinedText", message);
+
+	SDL_Surface *surface = RenderOutlinedTextSurface(message, color, outlineColor, font, outlineFont);
+	SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+ 
+	//Clean up unneeded stuff
+	SDL_FreeSurface(surface);
+
+	if(IsDrawTraceRecording())
+		TraceRenderOutlinedText(message, color, outlineColor, font, outlineFont, texture);
 
 	return texture;
 }
@@ -186,6 +259,9 @@ void DrawTextureToRenderer(SDL_Texture *texture, SDL_Renderer *renderer, int x,
 	//Query the texture to get its width and height to use
 	SDL_QueryTexture(texture, NULL, NULL, &dst.w, &dst.h);
 	SDL_RenderCopy(renderer, texture, NULL, &dst);
+
+	if(IsDrawTraceRecording())
+		TraceDrawTexture(texture, x, y);
 }
 
 void logSDLError(std::ostream &os, const std::string &msg)
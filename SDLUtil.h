@@ -24,6 +24,13 @@
 *   other general functions.
 */
 
+/**
+* The logical size of the renderer in pixels. Everything is drawn in this
+* coordinate space and scaled to the window by SDL.
+*/
+const int LogicalWidth = 640;
+const int LogicalHeight = 360;
+
 /**
 * Initialize SDL and create a window
 * @param windowName The title of the window
@@ -66,6 +73,16 @@ SDL_Surface* LoadSurfaceFromFile(const String& file);
 */
 SDL_Texture* LoadTextureFromFile(const String& file, SDL_Renderer *renderer);
 
+/**
+* Get the largest texture the renderer can create
+*
+* @param renderer The renderer to check
+* @param width Filled with the maximum texture width in pixels
+* @param height Filled with the maximum texture height in pixels
+* @return true if the renderer has a limit; false if it has none or there was an error
+*/
+bool GetMaxTextureSize(SDL_Renderer *renderer, int* width, int* height);
+
 /**
 * Use the special GFX library blit function to avoid transparency loss
 *
@@ -87,7 +104,10 @@ SDL_Texture* LoadTextureFromFile(const String& file, SDL_Renderer *renderer);
 void DrawTextureToRenderer(SDL_Texture *texture, SDL_Renderer *renderer, int x, int y);
 
 /**
-* Open a TTF_Font object with the specified size
+* Open a TTF_Font object with the specified size. The font file is read once and shared
+* with every other size, so the caller must close the font with TTF_CloseFont before
+* calling ShutdownFonts; a font left open reads freed bytes. Use GetFont for fonts that
+* should be cached.
 *
 * @param file The file name of the font
 * @param fontSize The size of the font to use
@@ -118,6 +138,19 @@ SDL_Texture* RenderText(const String& message, SDL_Color color, TTF_Font *font,
 SDL_Texture* RenderOutlinedText(const String& message, SDL_Color color, SDL_Color outlineColor,
 								TTF_Font *font, TTF_Font *outlinefont, SDL_Renderer* renderer);
 
+/**
+* Return a surface of a ttf message that has an outline. The caller must free the surface.
+*
+* @param message The message to display
+* @param color The SDL_Color to use
+* @param outlineColor The SDL_Color to use for the outline
+* @param font The font
+* @param outlinefont The font for the outline
+* @return SDL_Surface* The surface, nullptr for an empty message or if rendering failed
+*/
+SDL_Surface* RenderOutlinedTextSurface(const String& message, SDL_Color color, SDL_Color outlineColor,
+										TTF_Font *font, TTF_Font *outlinefont);
+
 /**
 * Log an SDL error with some error message to the output stream of our choice
 * @param os The output stream to write the message too
@@ -0,0 +1,34 @@
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+
+/**
+*    SimdKernels.h
+*
+*	This file picks which vector instruction sets the pixel kernels are built with. SSE2
+*	is part of every x86-64 CPU and NEON of every ARMv8 one, so those kernels are built
+*	for the whole file. AVX2 is not, so only the functions marked with SIMD_AVX2_TARGET
+*	are built for it and the caller must check SDL_HasAVX2 before running them.
+*
+*		SIMD_AVX2_TARGET static void RowAVX2(Uint32* pixels, int count);
+*/
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SIMD_SSE2
+	#include <emmintrin.h>
+
+	//MSVC builds any intrinsic in any function, GCC and Clang need the target attribute
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#define SIMD_AVX2
+		#define SIMD_AVX2_TARGET
+		#include <immintrin.h>
+	#elif defined(__GNUC__) || defined(__clang__)
+		#define SIMD_AVX2
+		#define SIMD_AVX2_TARGET __attribute__((target("avx2")))
+		#include <immintrin.h>
+	#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define SIMD_NEON
+	#include <arm_neon.h>
+#endif
+
+#endif //SIMDKERNELS_H
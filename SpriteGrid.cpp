@@ -0,0 +1,407 @@
+#include "stdafx.h"
+
+#include "SpriteGrid.h"
+#include "DrawTrace.h"
+
+#include <algorithm>
+
+/**
+*    SpriteGrid.cpp
+*
+*	This file has all of the functions used to place sprite and animation instances in a
+*	level and recall the visible ones. The level is split into square cells and each cell
+*	keeps the ids of every instance that overlaps it, so a query only walks the cells
+*	under the camera.
+*
+*	Instances keep pointers to their references and texture so drawing needs no lookups.
+*	When the texture references are replaced or freed the pointers are looked up again
+*	from the reference names before any instance is used.
+*/
+
+std::vector<SpriteInstance*> spriteInstances;
+std::vector<int> freeSpriteInstances;
+std::vector<std::vector<int> > spriteGridCells;
+std::vector<SpriteInstance*> visibleSpriteInstances;
+int spriteGridColumns = 0;
+int spriteGridRows = 0;
+int spriteGridCellSize = 128;
+unsigned int spriteInstanceOrder = 0;
+unsigned int spriteGridQueryMark = 0;
+unsigned int spriteGridTextureGeneration = 0;
+
+/**
+*	Fills the range of cells covered by the rectangle, clamped to the grid
+*/
+static bool GetCellRange(int x, int y, int w, int h, int* firstColumn, int* firstRow, int* lastColumn, int* lastRow)
+{
+	if(spriteGridColumns == 0 || w <= 0 || h <= 0)
+		return false;
+
+	//floor division so instances partly left of or above the level land in the first cell
+	*firstColumn = std::max((x >= 0 ? x : x - spriteGridCellSize + 1) / spriteGridCellSize, 0);
+	*firstRow = std::max((y >= 0 ? y : y - spriteGridCellSize + 1) / spriteGridCellSize, 0);
+	*lastColumn = std::min((x + w - 1) / spriteGridCellSize, spriteGridColumns - 1);
+	*lastRow = std::min((y + h - 1) / spriteGridCellSize, spriteGridRows - 1);
+
+	return *firstColumn <= *lastColumn && *firstRow <= *lastRow;
+}
+
+static void InsertIntoCells(SpriteInstance* s)
+{
+	int firstColumn, firstRow, lastColumn, lastRow;
+	if(!GetCellRange(s->x, s->y, s->w, s->h, &firstColumn, &firstRow, &lastColumn, &lastRow))
+		return;
+
+	for(int r = firstRow; r <= lastRow; r++)
+		for(int c = firstColumn; c <= lastColumn; c++)
+			spriteGridCells[r * spriteGridColumns + c].push_back(s->id);
+}
+
+static void RemoveFromCells(SpriteInstance* s)
+{
+	int firstColumn, firstRow, lastColumn, lastRow;
+	if(!GetCellRange(s->x, s->y, s->w, s->h, &firstColumn, &firstRow, &lastColumn, &lastRow))
+		return;
+
+	for(int r = firstRow; r <= lastRow; r++)
+	{
+		for(int c = firstColumn; c <= lastColumn; c++)
+		{
+			//swap with the last id, cell order does not matter
+			std::vector<int>& cell = spriteGridCells[r * spriteGridColumns + c];
+			std::vector<int>::iterator it = std::find(cell.begin(), cell.end(), s->id);
+			if(it != cell.end())
+			{
+				*it = cell.back();
+				cell.pop_back();
+			}
+		}
+	}
+}
+
+static bool CompareSpriteInstances(const SpriteInstance* a, const SpriteInstance* b)
+{
+	if(a->layer != b->layer)
+		return a->layer < b->layer;
+
+	return a->order < b->order;
+}
+
+void InitializeSpriteGrid(int levelWidth, int levelHeight, int cellSize)
+{
+	ShutdownSpriteGrid();
+
+	if(cellSize <= 0)
+	{
+		logError(std::cout, "InitializeSpriteGrid: cell size must be greater than 0");
+		return;
+	}
+
+	spriteGridCellSize = cellSize;
+	spriteGridColumns = std::max((levelWidth + cellSize - 1) / cellSize, 1);
+	spriteGridRows = std::max((levelHeight + cellSize - 1) / cellSize, 1);
+	spriteGridCells.resize(spriteGridColumns * spriteGridRows);
+}
+
+void ShutdownSpriteGrid()
+{
+	for(size_t i = 0; i < spriteInstances.size(); i++)
+		delete spriteInstances[i];
+
+	spriteInstances.clear();
+	freeSpriteInstances.clear();
+	spriteGridCells.clear();
+	visibleSpriteInstances.clear();
+	spriteGridColumns = 0;
+	spriteGridRows = 0;
+	spriteInstanceOrder = 0;
+}
+
+/**
+*	Look up the reference and texture of an instance by its reference name, returns
+*	whether the reference was found
+*/
+static bool ResolveSpriteInstance(SpriteInstance* s)
+{
+	s->sprite = nullptr;
+	s->animation = nullptr;
+	s->clip = nullptr;
+	s->texture = nullptr;
+
+	if(s->type == TextureType_Sprite)
+	{
+		s->sprite = GetSpriteReference(s->reference);
+		if(s->sprite)
+		{
+			s->w = s->sprite->w;
+			s->h = s->sprite->h;
+		}
+	}
+	else if(s->type == TextureType_Animation)
+	{
+		s->animation = GetAnimationReference(s->reference);
+		if(s->animation)
+		{
+			s->clip = GetAnimationClip(s->reference);
+			s->w = s->animation->w;
+			s->h = s->animation->h;
+		}
+	}
+
+	if(!s->sprite && !s->animation)
+		return false;
+
+	s->texture = GetTexture(s->type, s->reference);
+
+	return true;
+}
+
+/**
+*	Look up every instance again if the texture references changed since they were last
+*	looked up. Instances whose reference is gone stay placed but are not drawn.
+*/
+static void RefreshSpriteInstances()
+{
+	unsigned int generation = GetTextureReferenceGeneration();
+	if(generation == spriteGridTextureGeneration)
+		return;
+
+	spriteGridTextureGeneration = generation;
+
+	for(size_t i = 0; i < spriteInstances.size(); i++)
+	{
+		SpriteInstance* s = spriteInstances[i];
+		if(!s)
+			continue;
+
+		//the size can change with the reference, so the covered cells can too
+		RemoveFromCells(s);
+		if(!ResolveSpriteInstance(s))
+			s->w = s->h = 0;
+		InsertIntoCells(s);
+	}
+}
+
+int AddSpriteInstance(TextureType type, const String& reference, int x, int y, int layer)
+{
+	RefreshSpriteInstances();
+
+	SpriteInstance* s = new SpriteInstance();
+
+	s->type = type;
+	s->reference = reference;
+
+	if(!ResolveSpriteInstance(s))
+	{
+		delete s;
+		return -1;
+	}
+
+	s->frame = 0;
+	s->layer = layer;
+	s->x = x;
+	s->y = y;
+	s->order = spriteInstanceOrder++;
+	s->queryMark = spriteGridQueryMark;
+
+	if(!freeSpriteInstances.empty())
+	{
+		s->id = freeSpriteInstances.back();
+		freeSpriteInstances.pop_back();
+		spriteInstances[s->id] = s;
+	}
+	else
+	{
+		s->id = (int)spriteInstances.size();
+		spriteInstances.push_back(s);
+	}
+
+	InsertIntoCells(s);
+
+	return s->id;
+}
+
+SpriteInstance* GetSpriteInstance(int id)
+{
+	RefreshSpriteInstances();
+
+	if(id < 0 || id >= (int)spriteInstances.size())
+		return nullptr;
+
+	return spriteInstances[id];
+}
+
+void MoveSpriteInstance(int id, int x, int y)
+{
+	SpriteInstance* s = GetSpriteInstance(id);
+	if(!s)
+	{
+		logError(std::cout, "MoveSpriteInstance: warning instance " + IntToString(id) + " not found");
+		return;
+	}
+
+	//only touch the cells when the covered range changes
+	int oldRange[4], newRange[4];
+	bool oldValid = GetCellRange(s->x, s->y, s->w, s->h, &oldRange[0], &oldRange[1], &oldRange[2], &oldRange[3]);
+	bool newValid = GetCellRange(x, y, s->w, s->h, &newRange[0], &newRange[1], &newRange[2], &newRange[3]);
+
+	if(oldValid == newValid && (!oldValid || std::equal(oldRange, oldRange + 4, newRange)))
+	{
+		s->x = x;
+		s->y = y;
+		return;
+	}
+
+	RemoveFromCells(s);
+	s->x = x;
+	s->y = y;
+	InsertIntoCells(s);
+}
+
+void SetSpriteInstanceFrame(int id, int frame)
+{
+	SpriteInstance* s = GetSpriteInstance(id);
+	if(!s)
+	{
+		logError(std::cout, "SetSpriteInstanceFrame: warning instance " + IntToString(id) + " not found");
+		return;
+	}
+
+	s->frame = frame;
+}
+
+void RemoveSpriteInstance(int id)
+{
+	SpriteInstance* s = GetSpriteInstance(id);
+	if(!s)
+	{
+		logError(std::cout, "RemoveSpriteInstance: warning instance " + IntToString(id) + " not found");
+		return;
+	}
+
+	RemoveFromCells(s);
+	spriteInstances[id] = nullptr;
+	freeSpriteInstances.push_back(id);
+	delete s;
+}
+
+void GetVisibleSpriteInstances(int cameraX, int cameraY, std::vector<SpriteInstance*>& visible, int viewWidth, int viewHeight)
+{
+	visible.clear();
+	RefreshSpriteInstances();
+
+	int firstColumn, firstRow, lastColumn, lastRow;
+	if(!GetCellRange(cameraX, cameraY, viewWidth, viewHeight, &firstColumn, &firstRow, &lastColumn, &lastRow))
+		return;
+
+	//a new mark each query so instances spanning several cells are only added once
+	spriteGridQueryMark++;
+
+	for(int r = firstRow; r <= lastRow; r++)
+	{
+		for(int c = firstColumn; c <= lastColumn; c++)
+		{
+			const std::vector<int>& cell = spriteGridCells[r * spriteGridColumns + c];
+			for(size_t i = 0; i < cell.size(); i++)
+			{
+				SpriteInstance* s = spriteInstances[cell[i]];
+				if(s->queryMark == spriteGridQueryMark)
+					continue;
+				s->queryMark = spriteGridQueryMark;
+
+				//cells are coarse so test the instance against the view itself
+				if(s->x < cameraX + viewWidth && s->x + s->w > cameraX &&
+				   s->y < cameraY + viewHeight && s->y + s->h > cameraY)
+					visible.push_back(s);
+			}
+		}
+	}
+
+	std::sort(visible.begin(), visible.end(), CompareSpriteInstances);
+}
+
+/**
+*	Bring an instance's frame into its clip, wrapping a looping clip and holding a OneShot
+*/
+static int GetSpriteInstanceStep(const SpriteInstance* s)
+{
+	const AnimationClip* clip = s->clip;
+	if(!clip->loops)
+		return std::max(0, std::min(s->frame, clip->steps - 1));
+
+	int step = s->frame % clip->steps;
+	return step < 0 ? step + clip->steps : step;
+}
+
+void DrawVisibleSpriteInstances(SDL_Renderer* renderer, int cameraX, int cameraY)
+{
+	GetVisibleSpriteInstances(cameraX, cameraY, visibleSpriteInstances);
+
+	SDL_Rect source;
+	SDL_Rect destination;
+
+	for(size_t i = 0; i < visibleSpriteInstances.size(); i++)
+	{
+		SpriteInstance* s = visibleSpriteInstances[i];
+
+		source.w = s->w;
+		source.h = s->h;
+		if(s->sprite)
+		{
+			source.x = s->sprite->x;
+			source.y = s->sprite->y;
+		}
+		else
+		{
+			const SDL_Rect& rect = s->clip->rects[GetSpriteInstanceStep(s)];
+			source.x = rect.x;
+			source.y = rect.y;
+		}
+
+		destination.x = s->x - cameraX;
+		destination.y = s->y - cameraY;
+		destination.w = s->w;
+		destination.h = s->h;
+
+		if(IsDrawTraceRecording())
+			TraceCopyTexture(s->texture, &source, &destination);
+
+		SDL_RenderCopy(renderer, s->texture, &source, &destination);
+	}
+}
+
+static const CollisionMask* GetSpriteInstanceMask(const SpriteInstance* s)
+{
+	if(s->sprite)
+		return GetSpriteCollisionMask(s->reference);
+
+	return GetAnimationCollisionMask(s->reference, s->clip->frames[GetSpriteInstanceStep(s)]);
+}
+
+bool SpriteInstancesCollide(int a, int b)
+{
+	SpriteInstance* first = GetSpriteInstance(a);
+	SpriteInstance* second = GetSpriteInstance(b);
+	if(!first || !second)
+	{
+		logError(std::cout, "SpriteInstancesCollide: warning instance " + IntToString(first ? b : a) + " not found");
+		return false;
+	}
+
+	//an instance whose reference is gone has no size and touches nothing
+	if((!first->sprite && !first->clip) || (!second->sprite && !second->clip))
+		return false;
+
+	if(first->x >= second->x + second->w || second->x >= first->x + first->w ||
+	   first->y >= second->y + second->h || second->y >= first->y + first->h)
+		return false;
+
+	const CollisionMask* firstMask = GetSpriteInstanceMask(first);
+	const CollisionMask* secondMask = GetSpriteInstanceMask(second);
+
+	//without masks the rects overlapping is the answer
+	if(!firstMask || !secondMask)
+		return true;
+
+	return MasksOverlap(*firstMask, first->x, first->y, *secondMask, second->x, second->y);
+}
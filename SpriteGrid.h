@@ -0,0 +1,154 @@
+#ifndef SPRITEGRID_H
+#define SPRITEGRID_H
+
+#include "StringUtil.h"
+#include "Textures.h"
+#include "SDLUtil.h"
+
+/**
+*    SpriteGrid.h
+*
+*	This file has all of the functions used to place sprite and animation instances in a
+*	level and recall only the instances that are visible to the camera. Instances are
+*	stored in a uniform grid so the cost of a frame depends on what is on screen rather
+*	than on the size of the level.
+*
+*	Instances are kept by reference name. Their pointers are looked up again whenever
+*	the texture references change, such as when a palette variant is registered again,
+*	so an instance never draws through a freed reference.
+*/
+
+/**
+*	A struct to store a sprite or animation placed in the level
+*
+* @param type The TextureType of the reference
+* @param reference The unique name of the sprite or animation reference
+* @param texture The texture the reference is stored on
+* @param sprite The SpriteReference for TextureType_Sprite instances
+* @param animation The AnimationReference for TextureType_Animation instances
+* @param clip The compiled clip of the animation, drawn in place of its raw frames
+* @param frame The step of the clip to draw
+* @param layer The draw layer, lower layers are drawn first
+* @param x The x location of the instance in level coordinates
+* @param y The y location of the instance in level coordinates
+* @param w The width of the instance taken from the sprite or animation reference
+* @param h The height of the instance taken from the sprite or animation reference
+* @param id The id returned by AddSpriteInstance
+* @param order The order the instance was added in, used to keep draw order stable
+* @param queryMark Used by GetVisibleSpriteInstances to skip instances found in several cells
+*/
+struct SpriteInstance
+{
+	TextureType type;
+	String reference;
+	SDL_Texture* texture;
+	SpriteReference* sprite;
+	AnimationReference* animation;
+	const AnimationClip* clip;
+	int frame;
+	int layer;
+	int x;
+	int y;
+	int w;
+	int h;
+	int id;
+	unsigned int order;
+	unsigned int queryMark;
+};
+
+/**
+*    Setup the grid for a level. Call once before adding instances; calling again clears
+*    all instances.
+*
+* @param levelWidth The width of the level in pixels
+* @param levelHeight The height of the level in pixels
+* @param cellSize The width and height of a single grid cell in pixels
+*/
+void InitializeSpriteGrid(int levelWidth, int levelHeight, int cellSize = 128);
+
+/**
+*    Remove all instances and free the grid. Instances left placed across ShutdownTextures
+*    lose their references and are not drawn until the references are added again.
+*/
+void ShutdownSpriteGrid();
+
+/**
+*    Place a sprite or animation in the level. The bounds are taken from the w and h
+*    of the reference.
+*
+* @param type The TextureType of the reference
+* @param reference The unique name of the sprite or animation reference
+* @param x The x location of the instance in level coordinates
+* @param y The y location of the instance in level coordinates
+* @param layer The draw layer, lower layers are drawn first
+* @return int The id of the instance; -1 if the reference was not found
+*/
+int AddSpriteInstance(TextureType type, const String& reference, int x, int y, int layer = 0);
+
+/**
+*    Move a placed instance
+*
+* @param id The id returned by AddSpriteInstance
+* @param x The new x location in level coordinates
+* @param y The new y location in level coordinates
+*/
+void MoveSpriteInstance(int id, int x, int y);
+
+/**
+*    Set the frame drawn for a placed animation instance. Frames count through the clip so
+*    PingPong animations play back down; looping clips wrap the frame, negative frames
+*    included, and OneShot clips hold their last frame.
+*
+* @param id The id returned by AddSpriteInstance
+* @param frame The step of the animation's clip to draw
+*/
+void SetSpriteInstanceFrame(int id, int frame);
+
+/**
+*    Remove a placed instance. The id may be reused by a later AddSpriteInstance.
+*
+* @param id The id returned by AddSpriteInstance
+*/
+void RemoveSpriteInstance(int id);
+
+/**
+*	Return the placed instance stored under the given id
+*
+* @param id The id returned by AddSpriteInstance
+* @return SpriteInstance* A pointer to the instance or nullptr if the id is not in use
+*/
+SpriteInstance* GetSpriteInstance(int id);
+
+/**
+*	Fills a supplied vector with every instance that overlaps the camera's view, sorted
+*	by layer and then by the order they were added
+*
+* @param cameraX The x location of the upper left of the view in level coordinates
+* @param cameraY The y location of the upper left of the view in level coordinates
+* @param visible The vector to fill; it is cleared first
+* @param viewWidth The width of the view in pixels
+* @param viewHeight The height of the view in pixels
+*/
+void GetVisibleSpriteInstances(int cameraX, int cameraY, std::vector<SpriteInstance*>& visible,
+								int viewWidth = LogicalWidth, int viewHeight = LogicalHeight);
+
+/**
+*	Draw every visible instance relative to the camera
+*
+* @param renderer The renderer to draw too
+* @param cameraX The x location of the upper left of the view in level coordinates
+* @param cameraY The y location of the upper left of the view in level coordinates
+*/
+void DrawVisibleSpriteInstances(SDL_Renderer* renderer, int cameraX, int cameraY);
+
+/**
+*	Return whether two instances touch. Instances whose files were loaded with collision
+*	masks are compared pixel by pixel using their current frames, others by their rects.
+*
+* @param a The id of the first instance
+* @param b The id of the second instance
+* @return bool True if the instances overlap
+*/
+bool SpriteInstancesCollide(int a, int b);
+
+#endif //SPRITEGRID_H
@@ -0,0 +1,284 @@
+#include "stdafx.h"
+
+#include "SurfaceBlend.h"
+#include "SimdKernels.h"
+
+/**
+*    SurfaceBlend.cpp
+*
+*	The blend keeps the integer arithmetic of SDL 2.0's scalar BlitRGBtoRGBPixelAlpha: red
+*	and blue are blended together in one 32 bit lane as (d + ((s - d) * alpha >> 8)) & 0xff00ff,
+*	green on its own, and the destination alpha becomes alpha + (dalpha * (255 - alpha) >> 8).
+*	Fully transparent source pixels leave the destination alone and fully opaque ones replace
+*	it. The vector kernels do the same 32 bit wrapping math per lane so their output matches
+*	the scalar loop bit for bit.
+*/
+
+void BlendRowARGBScalar(const Uint32* source, Uint32* destination, int count)
+{
+	for(int i = 0; i < count; i++)
+	{
+		Uint32 s = source[i];
+		Uint32 alpha = s >> 24;
+
+		if(alpha == 0)
+			continue;
+
+		if(alpha == SDL_ALPHA_OPAQUE)
+		{
+			destination[i] = s;
+			continue;
+		}
+
+		Uint32 d = destination[i];
+		Uint32 dalpha = d >> 24;
+		Uint32 s1 = s & 0xff00ff;
+		Uint32 d1 = d & 0xff00ff;
+
+		d1 = (d1 + ((s1 - d1) * alpha >> 8)) & 0xff00ff;
+		s &= 0xff00;
+		d &= 0xff00;
+		d = (d + ((s - d) * alpha >> 8)) & 0xff00;
+		dalpha = alpha + (dalpha * (alpha ^ 0xff) >> 8);
+
+		destination[i] = d1 | d | (dalpha << 24);
+	}
+}
+
+#ifdef SIMD_SSE2
+
+/**
+*	32 bit multiply that keeps the low 32 bits, for a multiplier below 256 repeated in
+*	both 16 bit halves of each lane. SSE2 has no 32 bit multiply so it is built from the
+*	16 bit ones.
+*/
+static inline __m128i MultiplyLow32(__m128i x, __m128i alpha)
+{
+	return _mm_add_epi32(_mm_mullo_epi16(x, alpha), _mm_slli_epi32(_mm_mulhi_epu16(x, alpha), 16));
+}
+
+static void BlendRowARGBSSE2(const Uint32* source, Uint32* destination, int count)
+{
+	const __m128i redBlue = _mm_set1_epi32(0x00ff00ff);
+	const __m128i green = _mm_set1_epi32(0x0000ff00);
+	const __m128i opaque = _mm_set1_epi32(0xff);
+	const __m128i zero = _mm_setzero_si128();
+	int i = 0;
+
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i*)(source + i));
+		__m128i d = _mm_loadu_si128((const __m128i*)(destination + i));
+		__m128i alpha = _mm_srli_epi32(s, 24);
+		__m128i alphaPair = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+
+		__m128i d1 = _mm_and_si128(d, redBlue);
+		__m128i t = MultiplyLow32(_mm_sub_epi32(_mm_and_si128(s, redBlue), d1), alphaPair);
+		d1 = _mm_and_si128(_mm_add_epi32(d1, _mm_srli_epi32(t, 8)), redBlue);
+
+		__m128i d2 = _mm_and_si128(d, green);
+		t = MultiplyLow32(_mm_sub_epi32(_mm_and_si128(s, green), d2), alphaPair);
+		d2 = _mm_and_si128(_mm_add_epi32(d2, _mm_srli_epi32(t, 8)), green);
+
+		//both values are below 256 so the 16 bit multiply is exact
+		__m128i dalpha = _mm_mullo_epi16(_mm_srli_epi32(d, 24), _mm_xor_si128(alpha, opaque));
+		dalpha = _mm_add_epi32(alpha, _mm_srli_epi32(dalpha, 8));
+
+		__m128i blended = _mm_or_si128(_mm_or_si128(d1, d2), _mm_slli_epi32(dalpha, 24));
+
+		__m128i isOpaque = _mm_cmpeq_epi32(alpha, opaque);
+		__m128i isClear = _mm_cmpeq_epi32(alpha, zero);
+		blended = _mm_or_si128(_mm_and_si128(isClear, d), _mm_andnot_si128(isClear, blended));
+		blended = _mm_or_si128(_mm_and_si128(isOpaque, s), _mm_andnot_si128(isOpaque, blended));
+
+		_mm_storeu_si128((__m128i*)(destination + i), blended);
+	}
+
+	BlendRowARGBScalar(source + i, destination + i, count - i);
+}
+
+#endif //SIMD_SSE2
+
+#ifdef SIMD_AVX2
+
+SIMD_AVX2_TARGET static inline __m256i MultiplyLow32AVX2(__m256i x, __m256i alpha)
+{
+	return _mm256_add_epi32(_mm256_mullo_epi16(x, alpha), _mm256_slli_epi32(_mm256_mulhi_epu16(x, alpha), 16));
+}
+
+SIMD_AVX2_TARGET static void BlendRowARGBAVX2(const Uint32* source, Uint32* destination, int count)
+{
+	const __m256i redBlue = _mm256_set1_epi32(0x00ff00ff);
+	const __m256i green = _mm256_set1_epi32(0x0000ff00);
+	const __m256i opaque = _mm256_set1_epi32(0xff);
+	const __m256i zero = _mm256_setzero_si256();
+	int i = 0;
+
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i s = _mm256_loadu_si256((const __m256i*)(source + i));
+		__m256i d = _mm256_loadu_si256((const __m256i*)(destination + i));
+		__m256i alpha = _mm256_srli_epi32(s, 24);
+		__m256i alphaPair = _mm256_or_si256(alpha, _mm256_slli_epi32(alpha, 16));
+
+		__m256i d1 = _mm256_and_si256(d, redBlue);
+		__m256i t = MultiplyLow32AVX2(_mm256_sub_epi32(_mm256_and_si256(s, redBlue), d1), alphaPair);
+		d1 = _mm256_and_si256(_mm256_add_epi32(d1, _mm256_srli_epi32(t, 8)), redBlue);
+
+		__m256i d2 = _mm256_and_si256(d, green);
+		t = MultiplyLow32AVX2(_mm256_sub_epi32(_mm256_and_si256(s, green), d2), alphaPair);
+		d2 = _mm256_and_si256(_mm256_add_epi32(d2, _mm256_srli_epi32(t, 8)), green);
+
+		__m256i dalpha = _mm256_mullo_epi16(_mm256_srli_epi32(d, 24), _mm256_xor_si256(alpha, opaque));
+		dalpha = _mm256_add_epi32(alpha, _mm256_srli_epi32(dalpha, 8));
+
+		__m256i blended = _mm256_or_si256(_mm256_or_si256(d1, d2), _mm256_slli_epi32(dalpha, 24));
+
+		blended = _mm256_blendv_epi8(blended, d, _mm256_cmpeq_epi32(alpha, zero));
+		blended = _mm256_blendv_epi8(blended, s, _mm256_cmpeq_epi32(alpha, opaque));
+
+		_mm256_storeu_si256((__m256i*)(destination + i), blended);
+	}
+
+	BlendRowARGBSSE2(source + i, destination + i, count - i);
+}
+
+#endif //SIMD_AVX2
+
+#ifdef SIMD_NEON
+
+static void BlendRowARGBNEON(const Uint32* source, Uint32* destination, int count)
+{
+	const uint32x4_t redBlue = vdupq_n_u32(0x00ff00ff);
+	const uint32x4_t green = vdupq_n_u32(0x0000ff00);
+	const uint32x4_t opaque = vdupq_n_u32(0xff);
+	const uint32x4_t zero = vdupq_n_u32(0);
+	int i = 0;
+
+	for(; i + 4 <= count; i += 4)
+	{
+		uint32x4_t s = vld1q_u32(source + i);
+		uint32x4_t d = vld1q_u32(destination + i);
+		uint32x4_t alpha = vshrq_n_u32(s, 24);
+
+		uint32x4_t d1 = vandq_u32(d, redBlue);
+		uint32x4_t t = vmulq_u32(vsubq_u32(vandq_u32(s, redBlue), d1), alpha);
+		d1 = vandq_u32(vaddq_u32(d1, vshrq_n_u32(t, 8)), redBlue);
+
+		uint32x4_t d2 = vandq_u32(d, green);
+		t = vmulq_u32(vsubq_u32(vandq_u32(s, green), d2), alpha);
+		d2 = vandq_u32(vaddq_u32(d2, vshrq_n_u32(t, 8)), green);
+
+		uint32x4_t dalpha = vmulq_u32(vshrq_n_u32(d, 24), veorq_u32(alpha, opaque));
+		dalpha = vaddq_u32(alpha, vshrq_n_u32(dalpha, 8));
+
+		uint32x4_t blended = vorrq_u32(vorrq_u32(d1, d2), vshlq_n_u32(dalpha, 24));
+
+		blended = vbslq_u32(vceqq_u32(alpha, zero), d, blended);
+		blended = vbslq_u32(vceqq_u32(alpha, opaque), s, blended);
+
+		vst1q_u32(destination + i, blended);
+	}
+
+	BlendRowARGBScalar(source + i, destination + i, count - i);
+}
+
+#endif //SIMD_NEON
+
+typedef void (*BlendRowFunction)(const Uint32* source, Uint32* destination, int count);
+
+static BlendRowFunction GetBlendRowKernel(BlendKernel kernel)
+{
+	switch(kernel)
+	{
+		case BlendKernel_Scalar:
+			return BlendRowARGBScalar;
+		#ifdef SIMD_SSE2
+			case BlendKernel_SSE2:
+				return BlendRowARGBSSE2;
+		#endif
+		#ifdef SIMD_AVX2
+			case BlendKernel_AVX2:
+				return SDL_HasAVX2() ? BlendRowARGBAVX2 : nullptr;
+		#endif
+		#ifdef SIMD_NEON
+			case BlendKernel_NEON:
+				return BlendRowARGBNEON;
+		#endif
+		default:
+			return nullptr;
+	}
+}
+
+static BlendRowFunction SelectBlendRow()
+{
+	//the widest kernel this CPU runs
+	for(int kernel = BlendKernel_Count - 1; kernel > BlendKernel_Scalar; kernel--)
+	{
+		BlendRowFunction blendRow = GetBlendRowKernel((BlendKernel)kernel);
+		if(blendRow)
+			return blendRow;
+	}
+
+	return BlendRowARGBScalar;
+}
+
+void BlendRowARGB(const Uint32* source, Uint32* destination, int count)
+{
+	static const BlendRowFunction blendRow = SelectBlendRow();
+
+	blendRow(source, destination, count);
+}
+
+bool BlendRowARGBWithKernel(BlendKernel kernel, const Uint32* source, Uint32* destination, int count)
+{
+	BlendRowFunction blendRow = GetBlendRowKernel(kernel);
+	if(!blendRow)
+		return false;
+
+	blendRow(source, destination, count);
+
+	return true;
+}
+
+const char* GetBlendKernelName(BlendKernel kernel)
+{
+	static const char* const names[BlendKernel_Count] = {"scalar", "SSE2", "AVX2", "NEON"};
+
+	return kernel >= 0 && kernel < BlendKernel_Count ? names[kernel] : "unknown";
+}
+
+bool BlendSurfaceARGB(SDL_Surface* source, SDL_Surface* destination, int x, int y)
+{
+	if(source->format->format != SDL_PIXELFORMAT_ARGB8888 || destination->format->format != SDL_PIXELFORMAT_ARGB8888)
+		return false;
+
+	//clip the source to the destination
+	int sourceX = x < 0 ? -x : 0;
+	int sourceY = y < 0 ? -y : 0;
+	int width = SDL_min(source->w - sourceX, destination->w - (x + sourceX));
+	int height = SDL_min(source->h - sourceY, destination->h - (y + sourceY));
+
+	if(width <= 0 || height <= 0)
+		return true;
+
+	if(SDL_MUSTLOCK(source))
+		SDL_LockSurface(source);
+	if(SDL_MUSTLOCK(destination))
+		SDL_LockSurface(destination);
+
+	for(int row = 0; row < height; row++)
+	{
+		const Uint32* s = (const Uint32*)((const Uint8*)source->pixels + (sourceY + row) * source->pitch) + sourceX;
+		Uint32* d = (Uint32*)((Uint8*)destination->pixels + (y + sourceY + row) * destination->pitch) + x + sourceX;
+
+		BlendRowARGB(s, d, width);
+	}
+
+	if(SDL_MUSTLOCK(destination))
+		SDL_UnlockSurface(destination);
+	if(SDL_MUSTLOCK(source))
+		SDL_UnlockSurface(source);
+
+	return true;
+}
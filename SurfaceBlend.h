@@ -0,0 +1,80 @@
+#ifndef SURFACEBLEND_H
+#define SURFACEBLEND_H
+
+/**
+*    SurfaceBlend.h
+*
+*	This file has the alpha compositing used to put outlined text together. It blends one
+*	ARGB8888 surface onto another in a single pass with SSE2, AVX2 or NEON when available
+*	and a scalar loop otherwise. Every version uses the integer math of the scalar per pixel
+*	alpha blitter in SDL 2.0's SDL_blit_A.c (BlitRGBtoRGBPixelAlpha), which SDL_BlitSurface
+*	with SDL_BLENDMODE_BLEND picks for ARGB8888 when no SIMD blitter is built in.
+*
+*	The bytes only match SDL_BlitSurface when the linked SDL takes that scalar path. The
+*	MMX blitter on x86 builds, the ARM SIMD and NEON blitters and the reworked blend of
+*	later releases such as SDL 3 round differently, so outlined text can differ from an
+*	SDL blit by one step per channel there. tools/SurfaceBlendTest.cpp checks the SDL it
+*	is linked against.
+*/
+
+enum BlendKernel
+{
+	BlendKernel_Scalar,
+	BlendKernel_SSE2,
+	BlendKernel_AVX2,
+	BlendKernel_NEON,
+	BlendKernel_Count
+};
+
+/**
+* Blend an ARGB8888 surface onto another ARGB8888 surface using the source alpha.
+* The source is clipped to the destination.
+*
+* @param source The surface to blend
+* @param destination The surface to blend onto
+* @param x The x location on the destination of the source's upper left pixel
+* @param y The y location on the destination of the source's upper left pixel
+* @return true if the surfaces were blended; false if either is not ARGB8888
+*/
+bool BlendSurfaceARGB(SDL_Surface* source, SDL_Surface* destination, int x, int y);
+
+/**
+* Blend a row of ARGB8888 pixels with the fastest kernel the CPU supports
+*
+* @param source The pixels to blend
+* @param destination The pixels to blend onto
+* @param count The number of pixels in the row
+*/
+void BlendRowARGB(const Uint32* source, Uint32* destination, int count);
+
+/**
+* Blend a row of ARGB8888 pixels one pixel at a time. Used for the end of rows and on
+* CPUs without a vector kernel.
+*
+* @param source The pixels to blend
+* @param destination The pixels to blend onto
+* @param count The number of pixels in the row
+*/
+void BlendRowARGBScalar(const Uint32* source, Uint32* destination, int count);
+
+/**
+* Blend a row of ARGB8888 pixels with one particular kernel, so tools/SurfaceBlendTest can
+* check each kernel on its own
+*
+* @param kernel The kernel to use
+* @param source The pixels to blend
+* @param destination The pixels to blend onto
+* @param count The number of pixels in the row
+* @return true if the row was blended; false if the kernel was not built for this CPU or the CPU does not support it
+*/
+bool BlendRowARGBWithKernel(BlendKernel kernel, const Uint32* source, Uint32* destination, int count);
+
+/**
+* Return the name of a kernel for reports
+*
+* @param kernel The kernel
+* @return const char* The name of the kernel
+*/
+const char* GetBlendKernelName(BlendKernel kernel);
+
+#endif //SURFACEBLEND_H
@@ -0,0 +1,323 @@
+#include "stdafx.h"
+
+#include "TextLayout.h"
+#include "Trace.h"
+
+#include <map>
+
+/**
+*    TextLayout.cpp
+*
+*	This file has the text layout cache. Lines are broken by adding up glyph advances
+*	and kerning, the same way SDL_ttf sizes text, but each advance and kerning pair is
+*	asked of the font only once. Once broken each line is sized with TTF_SizeText, so
+*	its width takes in the outline, style and first glyph offset the same way the
+*	rendered line does. Text is treated as Latin-1 to match RenderText.
+*
+*	Layouts are kept by font and wrap width and then by message, so a lookup compares
+*	the message in place instead of copying it into a key.
+*/
+
+struct FontGlyphs
+{
+	int advances[256];
+	bool kerning;
+	std::map<Uint16, int> kerningPairs;
+};
+
+typedef std::pair<TTF_Font*, int> TextLayoutFont;
+typedef std::map<String, TextLayout*> TextLayoutMessages;
+
+std::map<TTF_Font*, FontGlyphs*> fontGlyphs;
+std::map<TextLayoutFont, TextLayoutMessages> textLayouts;
+int textLayoutCount = 0;
+unsigned int textLayoutUse = 0;
+
+static FontGlyphs* GetFontGlyphs(TTF_Font* font)
+{
+	std::map<TTF_Font*, FontGlyphs*>::iterator it = fontGlyphs.find(font);
+	if(it != fontGlyphs.end())
+		return it->second;
+
+	FontGlyphs* glyphs = new FontGlyphs();
+	for(int i = 0; i < 256; i++)
+		glyphs->advances[i] = -1;
+	glyphs->kerning = TTF_GetFontKerning(font) != 0;
+
+	fontGlyphs[font] = glyphs;
+
+	return glyphs;
+}
+
+static int GetGlyphAdvance(FontGlyphs* glyphs, TTF_Font* font, Uint8 c)
+{
+	if(glyphs->advances[c] < 0)
+	{
+		int minX, maxX, minY, maxY, advance;
+		if(TTF_GlyphMetrics(font, c, &minX, &maxX, &minY, &maxY, &advance) != 0)
+			advance = 0;
+		glyphs->advances[c] = advance;
+	}
+
+	return glyphs->advances[c];
+}
+
+static int GetGlyphKerning(FontGlyphs* glyphs, TTF_Font* font, Uint8 previous, Uint8 c)
+{
+	if(!glyphs->kerning)
+		return 0;
+
+	Uint16 pair = (Uint16)((previous << 8) | c);
+
+	std::map<Uint16, int>::iterator it = glyphs->kerningPairs.find(pair);
+	if(it != glyphs->kerningPairs.end())
+		return it->second;
+
+	int kerning = TTF_GetFontKerningSizeGlyphs(font, previous, c);
+	glyphs->kerningPairs[pair] = kerning;
+
+	return kerning;
+}
+
+/**
+*	Add the characters from start to end as a line, dropping the trailing spaces
+*/
+static void AddTextLine(TextLayout* layout, const String& message, size_t start, size_t end)
+{
+	while(end > start && message[end - 1] == ' ')
+		end--;
+
+	TextLine line;
+	line.text = message.substr(start, end - start);
+	line.width = 0;
+	line.y = (int)layout->lines.size() * TTF_FontLineSkip(layout->font);
+	line.texture = nullptr;
+
+	//the advances only pick the breaks, the width is what the rendered line will be
+	int height;
+	if(!line.text.empty() && TTF_SizeText(layout->font, line.text.c_str(), &line.width, &height) != 0)
+		line.width = 0;
+
+	if(line.width > layout->width)
+		layout->width = line.width;
+
+	layout->lines.push_back(line);
+}
+
+/**
+*	Break one paragraph, the text between two '\n', into lines no wider than the wrap width
+*/
+static void LayoutParagraph(TextLayout* layout, FontGlyphs* glyphs, const String& message, size_t start, size_t end, int wrapWidth)
+{
+	size_t lineStart = start;
+	size_t lastSpace = String::npos;
+	int width = 0;
+
+	size_t i = start;
+	while(i < end)
+	{
+		Uint8 c = (Uint8)message[i];
+
+		int advance = GetGlyphAdvance(glyphs, layout->font, c);
+		if(i > lineStart)
+			advance += GetGlyphKerning(glyphs, layout->font, (Uint8)message[i - 1], c);
+
+		//spaces may hang past the edge, they are trimmed from the line
+		if(wrapWidth > 0 && c != ' ' && i > lineStart && width + advance > wrapWidth)
+		{
+			if(lastSpace != String::npos && lastSpace > lineStart)
+			{
+				AddTextLine(layout, message, lineStart, lastSpace);
+				lineStart = lastSpace + 1;
+			}
+			else
+			{
+				//a single word wider than the line is broken where it overflows
+				AddTextLine(layout, message, lineStart, i);
+				lineStart = i;
+			}
+
+			//measure the rest of the word again at the start of the new line
+			i = lineStart;
+			lastSpace = String::npos;
+			width = 0;
+			continue;
+		}
+
+		if(c == ' ')
+			lastSpace = i;
+
+		width += advance;
+		i++;
+	}
+
+	AddTextLine(layout, message, lineStart, end);
+}
+
+static void DestroyTextLayout(TextLayout* layout)
+{
+	for(size_t i = 0; i < layout->lines.size(); i++)
+		if(layout->lines[i].texture)
+			SDL_DestroyTexture(layout->lines[i].texture);
+
+	delete layout;
+}
+
+static void DropOldestTextLayout()
+{
+	std::map<TextLayoutFont, TextLayoutMessages>::iterator oldestFont = textLayouts.end();
+	TextLayoutMessages::iterator oldest;
+
+	for(std::map<TextLayoutFont, TextLayoutMessages>::iterator layouts = textLayouts.begin(); layouts != textLayouts.end(); layouts++)
+	{
+		for(TextLayoutMessages::iterator it = layouts->second.begin(); it != layouts->second.end(); it++)
+		{
+			if(oldestFont == textLayouts.end() || it->second->lastUsed < oldest->second->lastUsed)
+			{
+				oldestFont = layouts;
+				oldest = it;
+			}
+		}
+	}
+
+	if(oldestFont == textLayouts.end())
+		return;
+
+	DestroyTextLayout(oldest->second);
+	oldestFont->second.erase(oldest);
+	if(oldestFont->second.empty())
+		textLayouts.erase(oldestFont);
+	textLayoutCount--;
+}
+
+TextLayout* GetTextLayout(const String& message, TTF_Font* font, int wrapWidth)
+{
+	if(font == nullptr)
+	{
+		logError(std::cout, "GetTextLayout: warning no font for " + message);
+		return nullptr;
+	}
+
+	std::map<TextLayoutFont, TextLayoutMessages>::iterator layouts = textLayouts.find(TextLayoutFont(font, wrapWidth));
+	if(layouts != textLayouts.end())
+	{
+		TextLayoutMessages::iterator it = layouts->second.find(message);
+		if(it != layouts->second.end())
+		{
+			it->second->lastUsed = ++textLayoutUse;
+			return it->second;
+		}
+	}
+
+	TRACE_SCOPE_ASSET("GetTextLayout", message);
+
+	if(textLayoutCount >= TextLayoutCacheSize)
+		DropOldestTextLayout();
+
+	TextLayout* layout = new TextLayout();
+	layout->font = font;
+	layout->width = 0;
+	layout->color.r = layout->color.g = layout->color.b = layout->color.a = 0;
+	layout->lastUsed = ++textLayoutUse;
+
+	FontGlyphs* glyphs = GetFontGlyphs(font);
+
+	size_t start = 0;
+	while(true)
+	{
+		size_t end = message.find('\n', start);
+		if(end == String::npos)
+		{
+			LayoutParagraph(layout, glyphs, message, start, message.size(), wrapWidth);
+			break;
+		}
+
+		LayoutParagraph(layout, glyphs, message, start, end, wrapWidth);
+		start = end + 1;
+	}
+
+	layout->height = ((int)layout->lines.size() - 1) * TTF_FontLineSkip(font) + TTF_FontHeight(font);
+
+	textLayouts[TextLayoutFont(font, wrapWidth)][message] = layout;
+	textLayoutCount++;
+
+	return layout;
+}
+
+void DrawTextLayout(TextLayout* layout, SDL_Color color, SDL_Renderer* renderer, int x, int y, TextAlign align)
+{
+	if(!layout)
+		return;
+
+	//textures from another color can not be reused
+	bool recolor = color.r != layout->color.r || color.g != layout->color.g ||
+				   color.b != layout->color.b || color.a != layout->color.a;
+	layout->color = color;
+
+	for(size_t i = 0; i < layout->lines.size(); i++)
+	{
+		TextLine& line = layout->lines[i];
+
+		//SDL_ttf can not render an empty line, it only takes up space
+		if(line.text.empty())
+			continue;
+
+		if(line.texture && recolor)
+		{
+			SDL_DestroyTexture(line.texture);
+			line.texture = nullptr;
+		}
+
+		if(!line.texture)
+			line.texture = RenderText(line.text, color, layout->font, renderer);
+
+		int lineX = x;
+		if(align == TextAlign_Center)
+			lineX += (layout->width - line.width) / 2;
+		else if(align == TextAlign_Right)
+			lineX += layout->width - line.width;
+
+		DrawTextureToRenderer(line.texture, renderer, lineX, y + line.y);
+	}
+}
+
+void DrawWrappedText(const String& message, TTF_Font* font, int wrapWidth, SDL_Color color, SDL_Renderer* renderer, int x, int y, TextAlign align)
+{
+	DrawTextLayout(GetTextLayout(message, font, wrapWidth), color, renderer, x, y, align);
+}
+
+void ClearTextLayouts(TTF_Font* font)
+{
+	std::map<TextLayoutFont, TextLayoutMessages>::iterator layouts = textLayouts.begin();
+	while(layouts != textLayouts.end())
+	{
+		if(font == nullptr || layouts->first.first == font)
+		{
+			for(TextLayoutMessages::iterator it = layouts->second.begin(); it != layouts->second.end(); it++)
+				DestroyTextLayout(it->second);
+
+			textLayoutCount -= (int)layouts->second.size();
+			textLayouts.erase(layouts++);
+		}
+		else
+			layouts++;
+	}
+
+	std::map<TTF_Font*, FontGlyphs*>::iterator glyphs = fontGlyphs.begin();
+	while(glyphs != fontGlyphs.end())
+	{
+		if(font == nullptr || glyphs->first == font)
+		{
+			delete glyphs->second;
+			fontGlyphs.erase(glyphs++);
+		}
+		else
+			glyphs++;
+	}
+}
+
+void ShutdownTextLayouts()
+{
+	ClearTextLayouts(nullptr);
+	textLayoutUse = 0;
+}
@@ -0,0 +1,117 @@
+#ifndef TEXTLAYOUT_H
+#define TEXTLAYOUT_H
+
+#include "StringUtil.h"
+#include "SDLUtil.h"
+
+/**
+*    TextLayout.h
+*
+*	This file has the text layout cache. A string is broken into lines for a font and
+*	wrap width once, using glyph advances and kerning cached per font, and every later
+*	request for the same string, font and width returns that layout. The line textures
+*	are rendered on the first draw and reused until the color changes.
+*
+*		DrawWrappedText(tutorialText, GetFont("font/main.ttf", 24), 300, white, renderer, 40, 40);
+*/
+
+//The most layouts kept, the least recently used one is dropped to make room
+const int TextLayoutCacheSize = 256;
+
+enum TextAlign
+{
+	TextAlign_Left,
+	TextAlign_Center,
+	TextAlign_Right
+};
+
+/**
+*	A single line of a layout
+*
+* @param text The characters on the line, without the break or trailing spaces
+* @param width The width of the rendered line in pixels
+* @param y The offset of the line from the top of the layout
+* @param texture The rendered line, nullptr until the layout is first drawn
+*/
+struct TextLine
+{
+	String text;
+	int width;
+	int y;
+	SDL_Texture* texture;
+};
+
+/**
+*	The lines of a string laid out for a font and wrap width
+*
+* @param font The font the layout was measured with
+* @param lines The lines from top to bottom
+* @param width The width of the widest line
+* @param height The height from the top of the first line to the bottom of the last
+* @param color The color the line textures were rendered in
+* @param lastUsed When the layout was last asked for, used to pick which layout to drop
+*/
+struct TextLayout
+{
+	TTF_Font* font;
+	std::vector<TextLine> lines;
+	int width;
+	int height;
+	SDL_Color color;
+	unsigned int lastUsed;
+};
+
+/**
+*	Return the layout of the message, laying it out the first time. Lines break at '\n'
+*	and, when a wrap width is given, between words. A word wider than the wrap width is
+*	broken between characters. The cache owns the layout so do not delete it, and ask for
+*	it again each frame rather than keeping the pointer since old layouts are dropped.
+*
+* @param message The message to lay out
+* @param font The font to measure with
+* @param wrapWidth The widest a line may be in pixels, 0 to only break at '\n'
+* @return TextLayout* The layout, nullptr if the font is nullptr
+*/
+TextLayout* GetTextLayout(const String& message, TTF_Font* font, int wrapWidth = 0);
+
+/**
+*	Draw a layout. Each line is rendered once and reused while the color stays the same.
+*
+* @param layout The layout from GetTextLayout
+* @param color The SDL_Color to use
+* @param renderer The renderer to draw too
+* @param x The x location of the layout
+* @param y The y location of the top of the layout
+* @param align How each line is placed within the width of the layout
+*/
+void DrawTextLayout(TextLayout* layout, SDL_Color color, SDL_Renderer* renderer, int x, int y, TextAlign align = TextAlign_Left);
+
+/**
+*	Lay out and draw a message, reusing the cached layout and line textures
+*
+* @param message The message to draw
+* @param font The font to use
+* @param wrapWidth The widest a line may be in pixels, 0 to only break at '\n'
+* @param color The SDL_Color to use
+* @param renderer The renderer to draw too
+* @param x The x location of the text
+* @param y The y location of the top of the text
+* @param align How each line is placed within the width of the text
+*/
+void DrawWrappedText(const String& message, TTF_Font* font, int wrapWidth, SDL_Color color, SDL_Renderer* renderer,
+						int x, int y, TextAlign align = TextAlign_Left);
+
+/**
+*	Drop the cached layouts and glyph measurements of a font. Call before closing a font
+*	so a font opened later at the same address is not given stale layouts.
+*
+* @param font The font to forget, nullptr for every font
+*/
+void ClearTextLayouts(TTF_Font* font = nullptr);
+
+/**
+*	Drop every cached layout and its textures. Call once before the renderer is destroyed.
+*/
+void ShutdownTextLayouts();
+
+#endif //TEXTLAYOUT_H
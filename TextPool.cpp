@@ -0,0 +1,287 @@
+#include "stdafx.h"
+
+#include "TextPool.h"
+#include "AllocationTracker.h"
+#include "Trace.h"
+
+#include <map>
+#include <string.h>
+
+/**
+*    TextPool.cpp
+*
+*	This file has the slots and the pooled streaming textures behind them. Free textures
+*	are kept in lists by their rounded size so a slot that grows, or a new slot, reuses a
+*	texture another slot gave back before a new one is created.
+*/
+
+struct TextSlot
+{
+	bool used;
+	SDL_Texture* texture;
+	int textureWidth;
+	int textureHeight;
+	SDL_Rect source;
+
+	//what was last rendered, to skip unchanged text
+	String message;
+	SDL_Color color;
+	SDL_Color outlineColor;
+	TTF_Font* font;
+	TTF_Font* outlineFont;
+};
+
+std::vector<TextSlot> textSlots;
+std::vector<int> freeTextSlots;
+std::map<int, std::vector<SDL_Texture*> > freeTextTextures;
+
+static int RoundUpToPowerOfTwo(int value, int minimum)
+{
+	int size = minimum;
+	while(size < value)
+		size *= 2;
+
+	return size;
+}
+
+static int TextTextureKey(int width, int height)
+{
+	return (width << 16) | height;
+}
+
+static bool SameColor(const SDL_Color& a, const SDL_Color& b)
+{
+	return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static void ReturnTextTexture(TextSlot& slot)
+{
+	if(slot.texture)
+		freeTextTextures[TextTextureKey(slot.textureWidth, slot.textureHeight)].push_back(slot.texture);
+
+	slot.texture = nullptr;
+	slot.textureWidth = 0;
+	slot.textureHeight = 0;
+}
+
+/**
+*	Make sure the slot's texture can hold width x height pixels
+*/
+static bool ReserveTextTexture(TextSlot& slot, int width, int height, SDL_Renderer* renderer)
+{
+	if(slot.texture && width <= slot.textureWidth && height <= slot.textureHeight)
+		return true;
+
+	ReturnTextTexture(slot);
+
+	int textureWidth = RoundUpToPowerOfTwo(width, TextPoolMinWidth);
+	int textureHeight = RoundUpToPowerOfTwo(height, TextPoolMinHeight);
+	std::vector<SDL_Texture*>& pooled = freeTextTextures[TextTextureKey(textureWidth, textureHeight)];
+
+	if(!pooled.empty())
+	{
+		slot.texture = pooled.back();
+		pooled.pop_back();
+	}
+	else
+	{
+		slot.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, textureWidth, textureHeight);
+		if(!slot.texture)
+		{
+			logSDLError(std::cout, "ReserveTextTexture");
+			return false;
+		}
+		SDL_SetTextureBlendMode(slot.texture, SDL_BLENDMODE_BLEND);
+	}
+
+	slot.textureWidth = textureWidth;
+	slot.textureHeight = textureHeight;
+
+	return true;
+}
+
+/**
+*	Copy a rendered message into the slot's texture and free the surface
+*/
+static SDL_Texture* UploadTextSurface(TextSlot& slot, SDL_Surface* surface, SDL_Renderer* renderer, SDL_Rect* source)
+{
+	slot.source.x = 0;
+	slot.source.y = 0;
+	slot.source.w = 0;
+	slot.source.h = 0;
+
+	//SDL_ttf gives no surface for an empty message, which is not an error here
+	if(!surface)
+	{
+		if(!slot.message.empty())
+			logSDLError(std::cout, "UploadTextSurface");
+		*source = slot.source;
+		return slot.texture;
+	}
+
+	if(surface->format->format != SDL_PIXELFORMAT_ARGB8888)
+	{
+		SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(surface);
+		surface = converted;
+		if(!surface)
+		{
+			logSDLError(std::cout, "UploadTextSurface");
+			*source = slot.source;
+			return slot.texture;
+		}
+	}
+
+	if(ReserveTextTexture(slot, surface->w, surface->h, renderer))
+	{
+		//clear one extra row and column when there is room so filtering at the edges
+		//does not pick up the text that used the texture before
+		SDL_Rect locked = {0, 0, SDL_min(surface->w + 1, slot.textureWidth), SDL_min(surface->h + 1, slot.textureHeight)};
+		void* pixels;
+		int pitch;
+
+		if(SDL_LockTexture(slot.texture, &locked, &pixels, &pitch) == 0)
+		{
+			for(int y = 0; y < locked.h; y++)
+			{
+				Uint8* row = (Uint8*)pixels + y * pitch;
+
+				if(y < surface->h)
+				{
+					memcpy(row, (Uint8*)surface->pixels + y * surface->pitch, surface->w * 4);
+					if(locked.w > surface->w)
+						memset(row + surface->w * 4, 0, 4);
+				}
+				else
+					memset(row, 0, locked.w * 4);
+			}
+			SDL_UnlockTexture(slot.texture);
+
+			slot.source.w = surface->w;
+			slot.source.h = surface->h;
+		}
+		else
+			logSDLError(std::cout, "UploadTextSurface");
+	}
+
+	SDL_FreeSurface(surface);
+	*source = slot.source;
+
+	return slot.texture;
+}
+
+static TextSlot* GetTextSlot(int slot)
+{
+	if(slot < 0 || slot >= (int)textSlots.size() || !textSlots[slot].used)
+	{
+		logError(std::cout, "GetTextSlot: warning slot " + IntToString(slot) + " not found");
+		return nullptr;
+	}
+
+	return &textSlots[slot];
+}
+
+int AcquireTextSlot()
+{
+	int id;
+
+	if(!freeTextSlots.empty())
+	{
+		id = freeTextSlots.back();
+		freeTextSlots.pop_back();
+	}
+	else
+	{
+		id = (int)textSlots.size();
+		textSlots.push_back(TextSlot());
+	}
+
+	TextSlot& slot = textSlots[id];
+	slot.used = true;
+	slot.texture = nullptr;
+	slot.textureWidth = 0;
+	slot.textureHeight = 0;
+	slot.source.x = slot.source.y = slot.source.w = slot.source.h = 0;
+	slot.message.clear();
+	slot.font = nullptr;
+	slot.outlineFont = nullptr;
+
+	return id;
+}
+
+void ReleaseTextSlot(int slot)
+{
+	TextSlot* s = GetTextSlot(slot);
+	if(!s)
+		return;
+
+	ReturnTextTexture(*s);
+	s->used = false;
+	s->message.clear();
+	freeTextSlots.push_back(slot);
+}
+
+SDL_Texture* RenderTextToSlot(int slot, const String& message, SDL_Color color, TTF_Font *font,
+								SDL_Renderer* renderer, SDL_Rect* source)
+{
+	TextSlot* s = GetTextSlot(slot);
+	if(!s)
+		return nullptr;
+
+	if(s->texture && s->font == font && !s->outlineFont && SameColor(s->color, color) && s->message == message)
+	{
+		*source = s->source;
+		return s->texture;
+	}
+
+	ALLOCATION_PHASE("text");
+	TRACE_SCOPE_ASSET("RenderTextToSlot", message);
+
+	s->message = message;
+	s->color = color;
+	s->font = font;
+	s->outlineFont = nullptr;
+
+	return UploadTextSurface(*s, TTF_RenderText_Blended(font, message.c_str(), color), renderer, source);
+}
+
+SDL_Texture* RenderOutlinedTextToSlot(int slot, const String& message, SDL_Color color, SDL_Color outlineColor,
+										TTF_Font *font, TTF_Font *outlineFont, SDL_Renderer* renderer, SDL_Rect* source)
+{
+	TextSlot* s = GetTextSlot(slot);
+	if(!s)
+		return nullptr;
+
+	if(s->texture && s->font == font && s->outlineFont == outlineFont && SameColor(s->color, color) &&
+	   SameColor(s->outlineColor, outlineColor) && s->message == message)
+	{
+		*source = s->source;
+		return s->texture;
+	}
+
+	ALLOCATION_PHASE("text");
+	TRACE_SCOPE_ASSET("RenderOutlinedTextToSlot", message);
+
+	s->message = message;
+	s->color = color;
+	s->outlineColor = outlineColor;
+	s->font = font;
+	s->outlineFont = outlineFont;
+
+	return UploadTextSurface(*s, RenderOutlinedTextSurface(message, color, outlineColor, font, outlineFont), renderer, source);
+}
+
+void ShutdownTextPool()
+{
+	for(size_t i = 0; i < textSlots.size(); i++)
+		if(textSlots[i].texture)
+			SDL_DestroyTexture(textSlots[i].texture);
+
+	for(std::map<int, std::vector<SDL_Texture*> >::iterator it = freeTextTextures.begin(); it != freeTextTextures.end(); it++)
+		for(size_t i = 0; i < it->second.size(); i++)
+			SDL_DestroyTexture(it->second[i]);
+
+	textSlots.clear();
+	freeTextSlots.clear();
+	freeTextTextures.clear();
+}
@@ -0,0 +1,82 @@
+#ifndef TEXTPOOL_H
+#define TEXTPOOL_H
+
+#include "StringUtil.h"
+#include "SDLUtil.h"
+
+/**
+*    TextPool.h
+*
+*	This file has the functions used to draw text that changes often, such as scores,
+*	timers and combo counters, without creating and destroying a texture each time. Each
+*	piece of text owns a slot. Rendering into the slot writes the text into a pooled
+*	streaming texture whose size is rounded up to a power of two, and only replaces that
+*	texture when the text outgrows it. The text fills the upper left of the texture, so
+*	always draw it with the returned source rect.
+*
+*		int score = AcquireTextSlot();
+*		...
+*		SDL_Rect source;
+*		SDL_Texture* texture = RenderTextToSlot(score, IntToString(points), white, font, renderer, &source);
+*		SDL_Rect destination = {x, y, source.w, source.h};
+*		SDL_RenderCopy(renderer, texture, &source, &destination);
+*/
+
+/**
+*	The smallest pooled texture size, smaller text is rounded up to this
+*/
+const int TextPoolMinWidth = 64;
+const int TextPoolMinHeight = 16;
+
+/**
+*	Reserve a slot for a piece of text
+*
+* @return int The slot id
+*/
+int AcquireTextSlot();
+
+/**
+*	Give a slot's texture back to the pool. The slot id may be reused by a later AcquireTextSlot.
+*
+* @param slot The slot id returned by AcquireTextSlot
+*/
+void ReleaseTextSlot(int slot);
+
+/**
+*	Render a ttf message into a slot. If the message, color and font are the same as the
+*	last call for the slot nothing is rendered.
+*
+* @param slot The slot id returned by AcquireTextSlot
+* @param message The message to display
+* @param color The SDL_Color to use
+* @param font The font
+* @param renderer The renderer to use
+* @param source Filled with the part of the texture that holds the message
+* @return SDL_Texture* The slot's texture; owned by the pool so do not destroy it
+*/
+SDL_Texture* RenderTextToSlot(int slot, const String& message, SDL_Color color, TTF_Font *font,
+								SDL_Renderer* renderer, SDL_Rect* source);
+
+/**
+*	Render a ttf message that has an outline into a slot. If the message, colors and fonts
+*	are the same as the last call for the slot nothing is rendered.
+*
+* @param slot The slot id returned by AcquireTextSlot
+* @param message The message to display
+* @param color The SDL_Color to use
+* @param outlineColor The SDL_Color to use for the outline
+* @param font The font
+* @param outlineFont The font for the outline
+* @param renderer The renderer to use
+* @param source Filled with the part of the texture that holds the message
+* @return SDL_Texture* The slot's texture; owned by the pool so do not destroy it
+*/
+SDL_Texture* RenderOutlinedTextToSlot(int slot, const String& message, SDL_Color color, SDL_Color outlineColor,
+										TTF_Font *font, TTF_Font *outlineFont, SDL_Renderer* renderer, SDL_Rect* source);
+
+/**
+*	Destroy every pooled texture and release every slot. Call once before shutting down the game.
+*/
+void ShutdownTextPool();
+
+#endif //TEXTPOOL_H
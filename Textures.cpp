@@ -2,10 +2,18 @@
 
 #include "Textures.h"
 #include "SDLUtil.h"
+#include "AllocationTracker.h"
+#include "Trace.h"
+#include "DrawTrace.h"
+#include "Qoi.h"
+#include "AsyncLog.h"
+#include "Archive.h"
 
 #include <stdio.h>
+#include <math.h>
 #include <map>
 #include <fstream>
+#include <algorithm>
 
 /**
 *    Textures.cpp
@@ -18,9 +26,53 @@
 std::map<String, SDL_Texture*> textureReferences;
 std::map<String, SpriteReference*> spriteReferences;
 std::map<String, AnimationReference*> animationReferences;
+std::vector<SDL_Texture*> textureFileSlots;
+std::vector<const char*> textureFileSlotNames;
+
+/**
+*	A part of an image that was too large for a single texture
+*
+* @param reference The reference of the texture holding the part
+* @param source The location of the part on the original image
+*/
+struct TextureTile
+{
+	String reference;
+	SDL_Rect source;
+};
+
+std::map<String, std::vector<TextureTile> > textureTiles;
+
+/**
+*	A recolored copy of a file made the first time it is used
+*
+* @param fileReference The reference of the original file
+* @param swaps The colors to replace
+* @param renderer The renderer to create the texture with
+* @param failed Whether making the texture failed, so it is not tried again every lookup
+*/
+struct PaletteVariant
+{
+	String fileReference;
+	std::vector<PaletteSwap> swaps;
+	SDL_Renderer* renderer;
+	bool failed;
+};
+
+std::map<String, String> textureFileNames;
+std::map<String, PaletteVariant> paletteVariants;
+std::map<String, CollisionMask> fileCollisionMasks;
+std::map<String, CollisionMask> spriteCollisionMasks;
+std::map<String, std::vector<CollisionMask> > animationCollisionMasks;
+
+//moved on whenever a reference or texture is replaced or freed, see GetTextureReferenceGeneration
+unsigned int textureReferenceGeneration = 0;
 
 void InitializeTextures(SDL_Renderer* renderer)
 {
+	ALLOCATION_PHASE("InitializeTextures");
+	TRACE_SCOPE("InitializeTextures");
+
 	LoadFile("image/sprites.png", "sprites", renderer);
 	LoadFile("image/ui.png", "ui", renderer);
 	AddFileReference("image/CloudBox.png", "CloudBox", renderer);
@@ -42,11 +94,24 @@ void InitializeTextures(SDL_Renderer* renderer)
 	AddSpriteReference("BubblePowerThree", "BubblePowerThree", 17, 17, 0, 0);
 }
 
-void LoadFile(const String& fileName, const String& reference, SDL_Renderer* renderer)
+void LoadFile(const String& fileName, const String& reference, SDL_Renderer* renderer, bool collisionMasks)
 {
+	TRACE_SCOPE_ASSET("LoadFile", fileName);
+
 	//Setup the text data filename
 	String dataFileName = fileName.substr(0, fileName.length() - 4) + ".txt";
 
+	//a packed data file is read straight from the archive
+	int archivedSize;
+	const Uint8* archived = GetArchivedAsset(dataFileName, &archivedSize);
+	if(archived)
+	{
+		ProcessTextData((const char*)archived, archivedSize, reference);
+		AddFileReference(fileName, reference, renderer, collisionMasks);
+		CompileAnimationClips();
+		return;
+	}
+
 	#ifdef __ANDROID__
 
 		//Open the file with RWops function and process each line
@@ -57,7 +122,8 @@ void LoadFile(const String& fileName, const String& reference, SDL_Renderer* ren
 			__android_log_write(ANDROID_LOG_INFO, "Chain Drop", "Loading texture file");
 			ProcessAndroidTextFile(rw, reference);
 			SDL_FreeRW(rw);
-			textureReferences[reference] = LoadTextureFromFile(fileName, renderer);
+			AddFileReference(fileName, reference, renderer, collisionMasks);
+			CompileAnimationClips();
 		}
 		else
 			logError(std::cout, "LoadFile: error opening: " + dataFileName);
@@ -76,13 +142,38 @@ void LoadFile(const String& fileName, const String& reference, SDL_Renderer* ren
 				ProcessFileLine(line, reference);
 			}
 			file.close();
-			textureReferences[reference] = LoadTextureFromFile(fileName, renderer);
+			AddFileReference(fileName, reference, renderer, collisionMasks);
+			CompileAnimationClips();
 		}
 		else
 			logError(std::cout, "LoadFile: error opening: " + dataFileName);
 	#endif
 }
 
+bool ProcessTextData(const char* data, int size, const String& reference)
+{
+	int lineStart = 0;
+
+	while(lineStart < size)
+	{
+		int lineEnd = lineStart;
+		while(lineEnd < size && data[lineEnd] != '\n')
+			lineEnd++;
+
+		//lines may end in \r\n or \n
+		int length = lineEnd - lineStart;
+		if(length > 0 && data[lineEnd - 1] == '\r')
+			length--;
+
+		if(length > 0 && !ProcessFileLine(String(data + lineStart, length), reference))
+			return false;
+
+		lineStart = lineEnd + 1;
+	}
+
+	return true;
+}
+
 bool ProcessAndroidTextFile(SDL_RWops* rw,  const String& reference)
 {
 	String s;
@@ -105,6 +196,9 @@ bool ProcessAndroidTextFile(SDL_RWops* rw,  const String& reference)
 
 bool ProcessFileLine(const String& line, const String& reference)
 {
+	TRACE_SCOPE_ASSET("ProcessFileLine", reference);
+	TRACE_BYTES(line.length());
+
 	StringList mValues;
 	mValues = SplitString(line, "\t", true);
 
@@ -128,18 +222,376 @@ bool ProcessFileLine(const String& line, const String& reference)
 		AddSpriteReference(reference, mValues[0], StringToInt(mValues[1]), StringToInt(mValues[2]),
 								StringToInt(mValues[3]), StringToInt(mValues[4]));
 	}
+	else if(mValues.size() == 9)
+	{
+		//add as single image with nine-slice borders
+		AddSpriteReference(reference, mValues[0], StringToInt(mValues[1]), StringToInt(mValues[2]),
+								StringToInt(mValues[3]), StringToInt(mValues[4]));
+		SetSpriteNineSlice(mValues[0], StringToInt(mValues[5]), StringToInt(mValues[6]),
+								StringToInt(mValues[7]), StringToInt(mValues[8]));
+	}
 	else
 		return false;
 
 	return true;
 }
 
-bool AddFileReference(const String& fileName, const String& reference, SDL_Renderer* renderer)
+/**
+*	Cut a collision mask for a sprite or frame from its file's mask, if the file has one
+*/
+static bool CutCollisionMask(const String& fileReference, int x, int y, int w, int h, CollisionMask& mask)
 {
-	if(textureReferences[reference] = LoadTextureFromFile(fileName, renderer))
-		return true;
-	else
+	std::map<String, CollisionMask>::iterator it = fileCollisionMasks.find(fileReference);
+	if(it == fileCollisionMasks.end())
 		return false;
+
+	CopyCollisionMask(it->second, x, y, w, h, mask);
+
+	return true;
+}
+
+static void AddFrameCollisionMask(const String& animationReference, size_t frame, const CollisionMask& mask)
+{
+	std::vector<CollisionMask>& masks = animationCollisionMasks[animationReference];
+	masks.resize(frame);
+	masks.push_back(mask);
+}
+
+/**
+*	Keep the file's alpha as a mask and cut masks for the sprites and animations already added
+*/
+static void AddFileCollisionMasks(SDL_Surface* surface, const String& reference)
+{
+	if(!BuildCollisionMask(surface, fileCollisionMasks[reference]))
+	{
+		fileCollisionMasks.erase(reference);
+		return;
+	}
+
+	for(std::map<String, SpriteReference*>::iterator it = spriteReferences.begin(); it != spriteReferences.end(); it++)
+	{
+		SpriteReference* s = it->second;
+		if(s->fileReference == reference)
+			CutCollisionMask(reference, s->x, s->y, s->w, s->h, spriteCollisionMasks[s->spriteReference]);
+	}
+
+	for(std::map<String, AnimationReference*>::iterator it = animationReferences.begin(); it != animationReferences.end(); it++)
+	{
+		AnimationReference* a = it->second;
+		if(a->fileReference != reference)
+			continue;
+
+		std::vector<CollisionMask>& masks = animationCollisionMasks[a->animationReference];
+		masks.resize(a->frames.size());
+		for(size_t i = 0; i < a->frames.size(); i++)
+			CutCollisionMask(reference, a->frames[i].mX, a->frames[i].mY, a->w, a->h, masks[i]);
+	}
+}
+
+bool AddFileReference(const String& fileName, const String& reference, SDL_Renderer* renderer, bool collisionMasks)
+{
+	//a converted "name.qoi" next to the image decodes faster than the original
+	SDL_Surface* surface = LoadPreferredImageSurface(fileName);
+
+	if(!surface)
+		return false;
+
+	//kept so palette variants can be made from the original pixels
+	textureFileNames[reference] = fileName;
+
+	//built before tiling moves the sprites and animations onto the tiles
+	if(collisionMasks)
+		AddFileCollisionMasks(surface, reference);
+
+	bool added;
+	int maxWidth, maxHeight;
+
+	if(GetMaxTextureSize(renderer, &maxWidth, &maxHeight) && (surface->w > maxWidth || surface->h > maxHeight))
+		added = AddTiledFileReference(surface, reference, renderer, maxWidth, maxHeight);
+	else
+	{
+		SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+		if(!texture)
+			logSDLError(std::cout, "AddFileReference");
+
+		textureReferences[reference] = texture;
+		added = texture != nullptr;
+	}
+
+	SDL_FreeSurface(surface);
+
+	return added;
+}
+
+/**
+*	Copy part of a surface into a new texture stored under reference#index
+*/
+static String AddTileTexture(SDL_Surface* pageSurface, const String& reference, int index, SDL_Renderer* renderer)
+{
+	String tileReference = reference + "#" + IntToString(index);
+	SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, pageSurface);
+
+	if(!texture)
+		logSDLError(std::cout, "AddTileTexture");
+
+	textureReferences[tileReference] = texture;
+
+	return tileReference;
+}
+
+/**
+*	Places rects left to right in rows on a page no larger than the maximum texture size
+*/
+struct TilePage
+{
+	int maxWidth;
+	int maxHeight;
+	int cursorX;
+	int cursorY;
+	int rowHeight;
+	int usedWidth;
+	int usedHeight;
+
+	bool Place(int w, int h, int* x, int* y)
+	{
+		if(cursorX + w > maxWidth)
+		{
+			cursorX = 0;
+			cursorY += rowHeight;
+			rowHeight = 0;
+		}
+
+		if(w > maxWidth || cursorY + h > maxHeight)
+			return false;
+
+		*x = cursorX;
+		*y = cursorY;
+		cursorX += w + TilePadding;
+		rowHeight = std::max(rowHeight, h + TilePadding);
+		usedWidth = std::max(usedWidth, *x + w);
+		usedHeight = std::max(usedHeight, *y + h);
+
+		return true;
+	}
+};
+
+struct TilePlacement
+{
+	SDL_Rect source;
+	int page;
+	int x;
+	int y;
+};
+
+/**
+*	Place every rect of a group on the last page, or none of them if they do not all fit
+*/
+static bool PlaceTileGroup(std::vector<TilePage>& pages, const std::vector<SDL_Rect>& rects, std::vector<TilePlacement>& placements)
+{
+	TilePage page = pages.back();
+	size_t first = placements.size();
+
+	for(size_t r = 0; r < rects.size(); r++)
+	{
+		TilePlacement p;
+		p.source = rects[r];
+		p.page = (int)pages.size() - 1;
+
+		if(!page.Place(rects[r].w, rects[r].h, &p.x, &p.y))
+		{
+			placements.resize(first);
+			return false;
+		}
+		placements.push_back(p);
+	}
+
+	pages.back() = page;
+
+	return true;
+}
+
+bool AddTiledFileReference(SDL_Surface* surface, const String& reference, SDL_Renderer* renderer, int maxWidth, int maxHeight)
+{
+	std::vector<SpriteReference*> sprites;
+	std::vector<AnimationReference*> animations;
+
+	for(std::map<String, SpriteReference*>::iterator it = spriteReferences.begin(); it != spriteReferences.end(); it++)
+		if(it->second->fileReference == reference)
+			sprites.push_back(it->second);
+
+	for(std::map<String, AnimationReference*>::iterator it = animationReferences.begin(); it != animationReferences.end(); it++)
+		if(it->second->fileReference == reference)
+			animations.push_back(it->second);
+
+	//copy pixels exactly, alpha included
+	SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+
+	if(sprites.empty() && animations.empty())
+	{
+		//nothing is known about the contents yet so cut the image into a grid of tiles
+		std::vector<TextureTile>& tiles = textureTiles[reference];
+		tiles.clear();
+
+		for(int y = 0; y < surface->h; y += maxHeight)
+		{
+			for(int x = 0; x < surface->w; x += maxWidth)
+			{
+				TextureTile tile;
+				tile.source.x = x;
+				tile.source.y = y;
+				tile.source.w = std::min(maxWidth, surface->w - x);
+				tile.source.h = std::min(maxHeight, surface->h - y);
+
+				SDL_Surface* tileSurface = CreateSurface(tile.source.w, tile.source.h);
+				if(!tileSurface)
+					return false;
+
+				SDL_BlitSurface(surface, &tile.source, tileSurface, NULL);
+				tile.reference = AddTileTexture(tileSurface, reference, (int)tiles.size(), renderer);
+				SDL_FreeSurface(tileSurface);
+				tiles.push_back(tile);
+			}
+		}
+
+		return true;
+	}
+
+	//the rects are known so pack only the used parts of the image onto as few pages as possible,
+	//keeping every frame of an animation on the same page so the animation has one texture
+	std::vector<TilePage> pages;
+	std::vector<TilePlacement> placements;
+	std::vector<int> spritePlacement(sprites.size(), -1);
+	std::vector<int> animationPlacement(animations.size(), -1);
+	size_t groupCount = sprites.size() + animations.size();
+
+	for(size_t g = 0; g < groupCount; g++)
+	{
+		std::vector<SDL_Rect> rects;
+
+		if(g < sprites.size())
+		{
+			SDL_Rect r = {sprites[g]->x, sprites[g]->y, sprites[g]->w, sprites[g]->h};
+			rects.push_back(r);
+		}
+		else
+		{
+			AnimationReference* a = animations[g - sprites.size()];
+			for(size_t f = 0; f < a->frames.size(); f++)
+			{
+				SDL_Rect r = {a->frames[f].mX, a->frames[f].mY, a->w, a->h};
+				rects.push_back(r);
+			}
+		}
+
+		//try the last page first, then a new one
+		if(pages.empty())
+		{
+			TilePage empty = {maxWidth, maxHeight, 0, 0, 0, 0, 0};
+			pages.push_back(empty);
+		}
+
+		size_t first = placements.size();
+		bool placed = PlaceTileGroup(pages, rects, placements);
+
+		if(!placed && pages.back().usedWidth > 0)
+		{
+			TilePage empty = {maxWidth, maxHeight, 0, 0, 0, 0, 0};
+			pages.push_back(empty);
+			placed = PlaceTileGroup(pages, rects, placements);
+			if(!placed)
+				pages.pop_back();
+		}
+
+		if(placed && g < sprites.size())
+			spritePlacement[g] = (int)first;
+		else if(placed)
+			animationPlacement[g - sprites.size()] = (int)first;
+
+		if(!placed)
+		{
+			String name = g < sprites.size() ? sprites[g]->spriteReference : animations[g - sprites.size()]->animationReference;
+			logError(std::cout, "AddTiledFileReference: " + name + " is larger than the maximum texture size");
+		}
+	}
+
+	std::vector<String> pageReferences;
+	for(size_t p = 0; p < pages.size(); p++)
+	{
+		//only left empty when nothing fit on it
+		if(pages[p].usedWidth == 0)
+		{
+			pageReferences.push_back("");
+			continue;
+		}
+
+		SDL_Surface* pageSurface = CreateSurface(pages[p].usedWidth, pages[p].usedHeight);
+		if(!pageSurface)
+			return false;
+
+		for(size_t i = 0; i < placements.size(); i++)
+		{
+			if(placements[i].page != (int)p)
+				continue;
+
+			SDL_Rect destination = {placements[i].x, placements[i].y, placements[i].source.w, placements[i].source.h};
+			SDL_BlitSurface(surface, &placements[i].source, pageSurface, &destination);
+		}
+
+		pageReferences.push_back(AddTileTexture(pageSurface, reference, (int)p, renderer));
+		SDL_FreeSurface(pageSurface);
+	}
+
+	//point every reference at its page
+	for(size_t i = 0; i < sprites.size(); i++)
+	{
+		if(spritePlacement[i] < 0)
+			continue;
+
+		const TilePlacement& p = placements[spritePlacement[i]];
+		sprites[i]->fileReference = pageReferences[p.page];
+		sprites[i]->x = p.x;
+		sprites[i]->y = p.y;
+	}
+
+	for(size_t i = 0; i < animations.size(); i++)
+	{
+		if(animationPlacement[i] < 0)
+			continue;
+
+		AnimationReference* a = animations[i];
+		for(size_t f = 0; f < a->frames.size(); f++)
+		{
+			const TilePlacement& p = placements[animationPlacement[i] + f];
+			a->frames[f].mX = p.x;
+			a->frames[f].mY = p.y;
+		}
+		a->fileReference = pageReferences[placements[animationPlacement[i]].page];
+		a->clipDirty = true;
+	}
+
+	//the references now draw from the pages
+	textureReferenceGeneration++;
+
+	return true;
+}
+
+/**
+*	Find the grid tile of a tiled file that holds the whole rect
+*/
+static const TextureTile* FindTextureTile(const String& fileReference, int x, int y, int w, int h)
+{
+	std::map<String, std::vector<TextureTile> >::iterator it = textureTiles.find(fileReference);
+	if(it == textureTiles.end())
+		return nullptr;
+
+	for(size_t i = 0; i < it->second.size(); i++)
+	{
+		const SDL_Rect& r = it->second[i].source;
+		if(x >= r.x && y >= r.y && x + w <= r.x + r.w && y + h <= r.y + r.h)
+			return &it->second[i];
+	}
+
+	return nullptr;
 }
 
 void AddSpriteReference(const String& fileReference, String spriteReference, int width, int height, int x, int y)
@@ -152,10 +604,50 @@ void AddSpriteReference(const String& fileReference, String spriteReference, int
 	s->y = y;
 	s->w = width;
 	s->h = height;
+	s->sliceLeft = 0;
+	s->sliceTop = 0;
+	s->sliceRight = 0;
+	s->sliceBottom = 0;
+
+	CollisionMask mask;
+	if(CutCollisionMask(fileReference, x, y, width, height, mask))
+		spriteCollisionMasks[spriteReference] = mask;
+
+	//the file was split into tiles when it was loaded, use the tile holding the sprite
+	if(textureTiles.find(fileReference) != textureTiles.end())
+	{
+		const TextureTile* tile = FindTextureTile(fileReference, x, y, width, height);
+		if(tile)
+		{
+			s->fileReference = tile->reference;
+			s->x = x - tile->source.x;
+			s->y = y - tile->source.y;
+		}
+		else
+			logError(std::cout, "AddSpriteReference: " + spriteReference + " crosses the tiles of " + fileReference);
+	}
 
 	spriteReferences[spriteReference] = s;
 }
 
+void SetSpriteNineSlice(const String& spriteReference, int left, int top, int right, int bottom)
+{
+	SpriteReference* s = GetSpriteReference(spriteReference);
+	if(!s)
+		return;
+
+	if(left < 0 || top < 0 || right < 0 || bottom < 0 || left + right > s->w || top + bottom > s->h)
+	{
+		logError(std::cout, "SetSpriteNineSlice: " + spriteReference + " borders do not fit the sprite");
+		return;
+	}
+
+	s->sliceLeft = left;
+	s->sliceTop = top;
+	s->sliceRight = right;
+	s->sliceBottom = bottom;
+}
+
 //void AddAnimationReference(const String& fileReference, String animationReference, int frameCount,
 //							int width, int height, int x, int y, int animationType, float frameDelay, int framesPerRow)
 //{
@@ -180,10 +672,36 @@ void AddAnimationReference(const String& fileReference, String animationReferenc
 {
 	AnimationReference* a = GetAnimationReference(animationReference, true);
 
+	//each frame's mask is cut at its place on the original image, before any tiling
+	CollisionMask mask;
+	bool hasMask = CutCollisionMask(fileReference, x, y, a ? a->w : width, a ? a->h : height, mask);
+
+	//the file was split into tiles when it was loaded, every frame must be on the first frame's tile
+	if(textureTiles.find(fileReference) != textureTiles.end())
+	{
+		const TextureTile* tile = FindTextureTile(fileReference, x, y, a ? a->w : width, a ? a->h : height);
+		if(!tile || (a && a->fileReference != tile->reference))
+		{
+			logError(std::cout, "AddAnimationReference: " + animationReference + " crosses the tiles of " + fileReference);
+			return;
+		}
+
+		x -= tile->source.x;
+		y -= tile->source.y;
+		if(!a)
+		{
+			AddAnimationReference(tile->reference, animationReference, width, height, x, y, animationType, frameDelay);
+			if(hasMask)
+				AddFrameCollisionMask(animationReference, 0, mask);
+			return;
+		}
+	}
+
 	if(a)
 	{
 		a->frames.push_back(AnimationFrame(x, y));
 		a->frameCount++;
+		a->clipDirty = true;
 	}
 	else
 	{
@@ -197,11 +715,17 @@ void AddAnimationReference(const String& fileReference, String animationReferenc
 		a->h = height;
 		a->frames.push_back(AnimationFrame(x, y));
 		a->frameCount++;
+		a->clipDirty = true;
 		animationReferences[animationReference] = a;
 	}
+
+	if(hasMask)
+		AddFrameCollisionMask(animationReference, a->frames.size() - 1, mask);
 }
 
-SDL_Texture* GetTexture(TextureType type, const String& reference)
+static SDL_Texture* FindTextureFileReference(const String& textureFileReference);
+
+static SDL_Texture* FindTexture(TextureType type, const String& reference)
 {
 	String textureName;// = nullptr;
 
@@ -210,7 +734,7 @@ SDL_Texture* GetTexture(TextureType type, const String& reference)
 		std::map<String, SpriteReference*>::iterator it = spriteReferences.find(reference);
 		if (it == spriteReferences.end())
 		{
-			logError(std::cout, "GetTextureString: warning " + reference + " not found");
+			logNotFound("GetTextureString", reference);
 			return nullptr;
 		}
 
@@ -221,35 +745,107 @@ SDL_Texture* GetTexture(TextureType type, const String& reference)
 		std::map<String, AnimationReference*>::iterator it = animationReferences.find(reference);
 		if (it == animationReferences.end())
 		{
-			logError(std::cout, "GetTextureString: warning " + reference + " not found");
+			logNotFound("GetTextureString", reference);
 			return nullptr;
 		}
 
 		textureName = it->second->fileReference;
 	}
 
-	return GetTextureFileReference(textureName);
+	return FindTextureFileReference(textureName);
+}
+
+SDL_Texture* GetTexture(TextureType type, const String& reference)
+{
+	SDL_Texture* texture = FindTexture(type, reference);
+
+	if(IsDrawTraceRecording())
+		TraceGetTexture(type, reference, texture);
+
+	return texture;
 }
 
 SDL_Texture* GetTextureFileReference(const String& textureFileReference)
+{
+	SDL_Texture* texture = FindTextureFileReference(textureFileReference);
+
+	if(IsDrawTraceRecording())
+		TraceGetTextureFileReference(textureFileReference, texture);
+
+	return texture;
+}
+
+/**
+*	Load the original image of a palette variant, recolor it and store the texture
+*/
+static SDL_Texture* AddPaletteVariantTexture(const String& variantReference, PaletteVariant& variant)
+{
+	TRACE_SCOPE_ASSET("AddPaletteVariantTexture", variantReference);
+
+	//a failure is kept until the variant is registered again, errors are logged once
+	variant.failed = true;
+
+	SDL_Surface* loaded = LoadPreferredImageSurface(textureFileNames[variant.fileReference]);
+	if(!loaded)
+		return nullptr;
+
+	SDL_Surface* surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+	SDL_FreeSurface(loaded);
+	if(!surface)
+	{
+		logSDLError(std::cout, "AddPaletteVariantTexture");
+		return nullptr;
+	}
+
+	RemapSurfaceColorsARGB(surface, variant.swaps);
+
+	SDL_Texture* texture = SDL_CreateTextureFromSurface(variant.renderer, surface);
+	SDL_FreeSurface(surface);
+
+	if(!texture)
+	{
+		logSDLError(std::cout, "AddPaletteVariantTexture");
+		return nullptr;
+	}
+
+	variant.failed = false;
+	textureReferences[variantReference] = texture;
+
+	return texture;
+}
+
+static SDL_Texture* FindTextureFileReference(const String& textureFileReference)
 {
 	std::map<String, SDL_Texture*>::iterator it = textureReferences.find(textureFileReference);
 	if (it == textureReferences.end())
 	{
-		logError(std::cout, "GetTextureReference: warning " + textureFileReference + " not found");
+		std::map<String, PaletteVariant>::iterator variant = paletteVariants.find(textureFileReference);
+		if(variant != paletteVariants.end())
+			return variant->second.failed ? nullptr : AddPaletteVariantTexture(variant->first, variant->second);
+
+		logNotFound("GetTextureReference", textureFileReference);
 		return nullptr;
 	}
 
 	return it->second;
 }
 
+String FindTextureFileReferenceName(SDL_Texture* texture)
+{
+	for(std::map<String, SDL_Texture*>::iterator it = textureReferences.begin(); it != textureReferences.end(); it++)
+		if(it->second == texture)
+			return it->first;
+
+	return String();
+}
+
 AnimationReference* GetAnimationReference(const String& animationReference, const bool& supressWarning)
 {
 	std::map<String, AnimationReference*>::iterator it = animationReferences.find(animationReference);
 	if (it == animationReferences.end())
 	{
 		if(!supressWarning)
-			logError(std::cout, "GetAnimationReference: warning " + animationReference + " not found");
+			logNotFound("GetAnimationReference", animationReference);
 		return nullptr;
 	}
 
@@ -261,7 +857,7 @@ SpriteReference* GetSpriteReference(const String& spriteReference)
 	std::map<String, SpriteReference*>::iterator it = spriteReferences.find(spriteReference);
 	if (it == spriteReferences.end())
 	{
-		logError(std::cout, "GetSpriteReference: warning " + spriteReference + " not found");
+		logNotFound("GetSpriteReference", spriteReference);
 		return nullptr;
 	}
 
@@ -270,11 +866,14 @@ SpriteReference* GetSpriteReference(const String& spriteReference)
 
 void SetSpriteSourceRect(const String& spriteReference, SDL_Rect* source)
 {
+	if(IsDrawTraceRecording())
+		TraceSpriteSourceRect(spriteReference);
+
 	std::map<String, SpriteReference*>::iterator it = spriteReferences.find(spriteReference);
 
 	if (it == spriteReferences.end())
 	{
-		logError(std::cout, "SetSpriteSourceRect: warning " + spriteReference + " not found");
+		logNotFound("SetSpriteSourceRect", spriteReference);
 		source->w = 0;
 		source->h = 0;
 		source->x = 0;
@@ -291,11 +890,14 @@ void SetSpriteSourceRect(const String& spriteReference, SDL_Rect* source)
 
 void SetAnimationSourceRect(const String& animationReference, const int frame, SDL_Rect* source)
 {
+	if(IsDrawTraceRecording())
+		TraceAnimationSourceRect(animationReference, frame);
+
 	std::map<String, AnimationReference*>::iterator it = animationReferences.find(animationReference);
 
 	if (it == animationReferences.end())
 	{
-		logError(std::cout, "SetAnimationSourceRect: warning " + animationReference + " not found");
+		logNotFound("SetAnimationSourceRect", animationReference);
 		source->w = 0;
 		source->h = 0;
 		source->x = 0;
@@ -304,14 +906,446 @@ void SetAnimationSourceRect(const String& animationReference, const int frame, S
 		return;
 	}
 
-	source->w = it->second->w;
-	source->h = it->second->h;
-	source->x = it->second->frames[frame].mX;
-	source->y = it->second->frames[frame].mY;
+	//out of range frames show the nearest end rather than reading past the frames
+	const AnimationReference* a = it->second;
+	const AnimationFrame& f = a->frames[std::max(0, std::min(frame, (int)a->frames.size() - 1))];
+
+	source->w = a->w;
+	source->h = a->h;
+	source->x = f.mX;
+	source->y = f.mY;
+}
+
+/**
+*	Lay the frames out in the order they are shown and total up when each one ends
+*/
+static void CompileAnimationClip(AnimationReference* a)
+{
+	AnimationClip& clip = a->clip;
+
+	//PingPong plays back down without showing either end frame twice
+	std::vector<int> order;
+	for(int f = 0; f < (int)a->frames.size(); f++)
+		order.push_back(f);
+	if(a->animationType == AnimationType_PingPong)
+		for(int f = (int)a->frames.size() - 2; f > 0; f--)
+			order.push_back(f);
+
+	clip.steps = (int)order.size();
+	clip.searchSteps = 1;
+	while(clip.searchSteps < clip.steps)
+		clip.searchSteps *= 2;
+	clip.loops = a->animationType != AnimationType_OneShot;
+
+	clip.rects.resize(clip.steps);
+	clip.ends.resize(clip.searchSteps);
+	clip.events.resize(clip.steps);
+	clip.frames.resize(clip.steps);
+
+	float time = 0.0f;
+	clip.holdTime = 0.0f;
+	for(int s = 0; s < clip.steps; s++)
+	{
+		const AnimationFrame& f = a->frames[order[s]];
+
+		//animations stepped by frame number have no delay, give each frame one unit
+		float duration = f.mDuration > 0.0f ? f.mDuration : a->frameDelay;
+		if(duration <= 0.0f)
+			duration = 1.0f;
+
+		clip.holdTime = time;
+		time += duration;
+
+		SDL_Rect r = {f.mX, f.mY, a->w, a->h};
+		clip.rects[s] = r;
+		clip.ends[s] = time;
+		clip.events[s] = f.mEvent;
+		clip.frames[s] = order[s];
+	}
+
+	clip.duration = time;
+	for(int s = clip.steps; s < clip.searchSteps; s++)
+		clip.ends[s] = time;
+
+	a->clipDirty = false;
+}
+
+static AnimationReference* GetAnimationFrame(const char* functionName, const String& animationReference, int frame)
+{
+	AnimationReference* a = GetAnimationReference(animationReference, true);
+	if(!a)
+	{
+		logNotFound(functionName, animationReference);
+		return nullptr;
+	}
+
+	if(frame < 0 || frame >= (int)a->frames.size())
+	{
+		char reference[LogReferenceLength];
+		SDL_snprintf(reference, sizeof(reference), "frame %d of %s", frame, animationReference.c_str());
+		logNotFound(functionName, reference);
+		return nullptr;
+	}
+
+	return a;
+}
+
+void SetAnimationFrameDuration(const String& animationReference, int frame, float duration)
+{
+	AnimationReference* a = GetAnimationFrame("SetAnimationFrameDuration", animationReference, frame);
+	if(!a)
+		return;
+
+	//compiled now so clips kept from GetAnimationClip see the change
+	a->frames[frame].mDuration = duration;
+	CompileAnimationClip(a);
+}
+
+void SetAnimationFrameEvent(const String& animationReference, int frame, int event)
+{
+	AnimationReference* a = GetAnimationFrame("SetAnimationFrameEvent", animationReference, frame);
+	if(!a)
+		return;
+
+	a->frames[frame].mEvent = event;
+	CompileAnimationClip(a);
+}
+
+void CompileAnimationClips()
+{
+	for(std::map<String, AnimationReference*>::iterator it = animationReferences.begin(); it != animationReferences.end(); it++)
+		if(it->second->clipDirty)
+			CompileAnimationClip(it->second);
+}
+
+const AnimationClip* GetAnimationClip(const String& animationReference)
+{
+	std::map<String, AnimationReference*>::iterator it = animationReferences.find(animationReference);
+	if(it == animationReferences.end())
+	{
+		logNotFound("GetAnimationClip", animationReference);
+		return nullptr;
+	}
+
+	if(it->second->clipDirty)
+		CompileAnimationClip(it->second);
+
+	return &it->second->clip;
+}
+
+/**
+*	Bring a time into the first pass of the clip, or hold it on the last step of a OneShot
+*/
+static float GetAnimationClipTime(const AnimationClip& clip, float time)
+{
+	float looped = time - floorf(time / clip.duration) * clip.duration;
+	float held = std::max(std::min(time, clip.holdTime), 0.0f);
+
+	return clip.loops ? looped : held;
+}
+
+/**
+*	Count the steps that end at or before the time. The search length only depends on the
+*	clip, and each halving adds its half multiplied by the comparison instead of branching.
+*/
+static int FindAnimationClipStep(const AnimationClip& clip, float time)
+{
+	const float* ends = &clip.ends[0];
+
+	int step = 0;
+	for(int half = clip.searchSteps / 2; half > 0; half /= 2)
+		step += (ends[step + half - 1] <= time) * half;
+
+	//rounding in the wrap can land exactly on the duration
+	return std::min(step, clip.steps - 1);
+}
+
+int GetAnimationClipStep(const AnimationClip& clip, float time)
+{
+	return FindAnimationClipStep(clip, GetAnimationClipTime(clip, time));
+}
+
+void SetAnimationClipSourceRect(const AnimationClip& clip, float time, SDL_Rect* source)
+{
+	*source = clip.rects[GetAnimationClipStep(clip, time)];
+}
+
+/**
+*	Number every step shown since the clip started, counting each pass of a looping clip
+*/
+static long long GetAnimationClipStepCount(const AnimationClip& clip, float time)
+{
+	long long passes = clip.loops ? (long long)floorf(time / clip.duration) : 0;
+
+	return passes * clip.steps + GetAnimationClipStep(clip, time);
+}
+
+int GetAnimationClipEvents(const AnimationClip& clip, float previousTime, float time, std::vector<int>& events)
+{
+	events.clear();
+
+	if(time < 0.0f)
+		return 0;
+
+	//a negative previous time means the clip is starting, so the first step is reached too
+	long long first = previousTime < 0.0f ? 0 : GetAnimationClipStepCount(clip, previousTime) + 1;
+	long long last = GetAnimationClipStepCount(clip, time);
+
+	//after a long pause only the last pass matters
+	first = std::max(first, last - clip.steps + 1);
+
+	for(long long s = first; s <= last; s++)
+	{
+		int event = clip.events[(int)(s % clip.steps)];
+		if(event != 0)
+			events.push_back(event);
+	}
+
+	return (int)events.size();
+}
+
+void BindTextureFileSlots(const char* const* fileReferences, int count)
+{
+	textureFileSlots.assign(count, nullptr);
+	textureFileSlotNames.assign(fileReferences, fileReferences + count);
+
+	for(int i = 0; i < count; i++)
+	{
+		//tiled files have no single texture and their rects were moved when they were packed,
+		//so the slot is left empty rather than drawing the generated rects from the wrong page
+		if(textureTiles.find(fileReferences[i]) != textureTiles.end() ||
+		   textureReferences.find(String(fileReferences[i]) + "#0") != textureReferences.end())
+		{
+			logError(std::cout, String("BindTextureFileSlots: ") + fileReferences[i] + " was tiled, use its string references");
+			continue;
+		}
+
+		textureFileSlots[i] = FindTextureFileReference(fileReferences[i]);
+	}
+}
+
+SDL_Texture* GetTextureFileSlot(int slot)
+{
+	SDL_Texture* texture = textureFileSlots[slot];
+	if(!texture)
+		logNotFound("GetTextureFileSlot", textureFileSlotNames[slot]);
+
+	return texture;
+}
+
+/**
+*	Shrink two borders in proportion when they do not fit the destination
+*/
+static void FitNineSliceBorders(int size, int* first, int* second)
+{
+	int total = *first + *second;
+	if(total <= size || total == 0)
+		return;
+
+	*first = *first * size / total;
+	*second = size - *first;
+}
+
+void DrawNineSlice(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* source,
+					int left, int top, int right, int bottom, const SDL_Rect* destination)
+{
+	if(!texture || destination->w <= 0 || destination->h <= 0)
+		return;
+
+	int destinationLeft = left, destinationRight = right;
+	int destinationTop = top, destinationBottom = bottom;
+	FitNineSliceBorders(destination->w, &destinationLeft, &destinationRight);
+	FitNineSliceBorders(destination->h, &destinationTop, &destinationBottom);
+
+	//column and row edges of the source and destination, outside to outside
+	int sourceX[4] = {source->x, source->x + left, source->x + source->w - right, source->x + source->w};
+	int sourceY[4] = {source->y, source->y + top, source->y + source->h - bottom, source->y + source->h};
+	int destinationX[4] = {destination->x, destination->x + destinationLeft,
+							destination->x + destination->w - destinationRight, destination->x + destination->w};
+	int destinationY[4] = {destination->y, destination->y + destinationTop,
+							destination->y + destination->h - destinationBottom, destination->y + destination->h};
+
+	for(int row = 0; row < 3; row++)
+	{
+		for(int column = 0; column < 3; column++)
+		{
+			SDL_Rect from = {sourceX[column], sourceY[row], sourceX[column + 1] - sourceX[column], sourceY[row + 1] - sourceY[row]};
+			SDL_Rect to = {destinationX[column], destinationY[row],
+							destinationX[column + 1] - destinationX[column], destinationY[row + 1] - destinationY[row]};
+
+			//borders of 0 and a center squeezed out leave empty parts
+			if(from.w <= 0 || from.h <= 0 || to.w <= 0 || to.h <= 0)
+				continue;
+
+			if(IsDrawTraceRecording())
+				TraceCopyTexture(texture, &from, &to);
+
+			SDL_RenderCopy(renderer, texture, &from, &to);
+		}
+	}
+}
+
+void DrawNineSliceSprite(SDL_Renderer* renderer, const String& spriteReference, const SDL_Rect* destination)
+{
+	SpriteReference* s = GetSpriteReference(spriteReference);
+	if(!s)
+		return;
+
+	SDL_Texture* texture = FindTextureFileReference(s->fileReference);
+
+	//recorded as a lookup so the replay finds the texture the same way and binds it for the nine copies
+	if(IsDrawTraceRecording())
+		TraceGetTextureFileReference(s->fileReference, texture);
+
+	SDL_Rect source = {s->x, s->y, s->w, s->h};
+	DrawNineSlice(renderer, texture, &source, s->sliceLeft, s->sliceTop, s->sliceRight, s->sliceBottom, destination);
+}
+
+void DrawFileReference(SDL_Renderer* renderer, const String& fileReference, int x, int y)
+{
+	std::map<String, std::vector<TextureTile> >::iterator it = textureTiles.find(fileReference);
+
+	if(it == textureTiles.end())
+	{
+		SDL_Texture* texture = FindTextureFileReference(fileReference);
+		if(texture)
+			DrawTextureToRenderer(texture, renderer, x, y);
+		return;
+	}
+
+	for(size_t i = 0; i < it->second.size(); i++)
+	{
+		const TextureTile& tile = it->second[i];
+		SDL_Rect destination = {x + tile.source.x, y + tile.source.y, tile.source.w, tile.source.h};
+		SDL_Texture* texture = textureReferences[tile.reference];
+
+		if(IsDrawTraceRecording())
+			TraceCopyTexture(texture, NULL, &destination);
+
+		SDL_RenderCopy(renderer, texture, NULL, &destination);
+	}
+}
+
+const CollisionMask* GetSpriteCollisionMask(const String& spriteReference)
+{
+	std::map<String, CollisionMask>::iterator it = spriteCollisionMasks.find(spriteReference);
+	if(it == spriteCollisionMasks.end())
+		return nullptr;
+
+	return &it->second;
+}
+
+const CollisionMask* GetAnimationCollisionMask(const String& animationReference, int frame)
+{
+	std::map<String, std::vector<CollisionMask> >::iterator it = animationCollisionMasks.find(animationReference);
+	if(it == animationCollisionMasks.end() || it->second.empty() || frame < 0)
+		return nullptr;
+
+	return &it->second[frame % it->second.size()];
+}
+
+bool RegisterPaletteVariant(const String& fileReference, const String& variant, const std::vector<PaletteSwap>& swaps,
+							SDL_Renderer* renderer)
+{
+	if(textureFileNames.find(fileReference) == textureFileNames.end())
+	{
+		logError(std::cout, "RegisterPaletteVariant: warning " + fileReference + " not found");
+		return false;
+	}
+
+	//tiled and packed files keep their parts under other references
+	if(textureTiles.find(fileReference) != textureTiles.end() ||
+	   textureReferences.find(fileReference + "#0") != textureReferences.end())
+	{
+		logError(std::cout, "RegisterPaletteVariant: " + fileReference + " was split into tiles and cannot have variants");
+		return false;
+	}
+
+	//a texture that failed to create is stored as nullptr
+	std::map<String, SDL_Texture*>::iterator original = textureReferences.find(fileReference);
+	if(original == textureReferences.end() || !original->second)
+	{
+		logError(std::cout, "RegisterPaletteVariant: error " + fileReference + " failed to load");
+		return false;
+	}
+
+	String variantReference = fileReference + "@" + variant;
+
+	//registering again replaces the colors, the texture is made again when next used
+	std::map<String, SDL_Texture*>::iterator texture = textureReferences.find(variantReference);
+	if(texture != textureReferences.end())
+	{
+		SDL_DestroyTexture(texture->second);
+		textureReferences.erase(texture);
+	}
+
+	PaletteVariant& v = paletteVariants[variantReference];
+	v.fileReference = fileReference;
+	v.swaps = swaps;
+	v.renderer = renderer;
+	v.failed = false;
+
+	std::vector<SpriteReference*> sprites;
+	for(std::map<String, SpriteReference*>::iterator it = spriteReferences.begin(); it != spriteReferences.end(); it++)
+		if(it->second->fileReference == fileReference)
+			sprites.push_back(it->second);
+
+	for(size_t i = 0; i < sprites.size(); i++)
+	{
+		SpriteReference* s = new SpriteReference(*sprites[i]);
+		s->fileReference = variantReference;
+		s->spriteReference = sprites[i]->spriteReference + "@" + variant;
+
+		std::map<String, SpriteReference*>::iterator old = spriteReferences.find(s->spriteReference);
+		if(old != spriteReferences.end())
+			delete old->second;
+		spriteReferences[s->spriteReference] = s;
+
+		std::map<String, CollisionMask>::iterator mask = spriteCollisionMasks.find(sprites[i]->spriteReference);
+		if(mask != spriteCollisionMasks.end())
+			spriteCollisionMasks[s->spriteReference] = mask->second;
+	}
+
+	std::vector<AnimationReference*> animations;
+	for(std::map<String, AnimationReference*>::iterator it = animationReferences.begin(); it != animationReferences.end(); it++)
+		if(it->second->fileReference == fileReference)
+			animations.push_back(it->second);
+
+	for(size_t i = 0; i < animations.size(); i++)
+	{
+		AnimationReference* a = new AnimationReference(*animations[i]);
+		a->fileReference = variantReference;
+		a->animationReference = animations[i]->animationReference + "@" + variant;
+
+		delete GetAnimationReference(a->animationReference, true);
+		animationReferences[a->animationReference] = a;
+
+		std::map<String, std::vector<CollisionMask> >::iterator masks = animationCollisionMasks.find(animations[i]->animationReference);
+		if(masks != animationCollisionMasks.end())
+			animationCollisionMasks[a->animationReference] = masks->second;
+	}
+
+	textureReferenceGeneration++;
+
+	return true;
+}
+
+unsigned int GetTextureReferenceGeneration()
+{
+	return textureReferenceGeneration;
 }
 
 void ShutdownTextures()
 {
+	textureFileSlots.clear();
+	textureFileSlotNames.clear();
+	textureTiles.clear();
+	textureFileNames.clear();
+	paletteVariants.clear();
+	fileCollisionMasks.clear();
+	spriteCollisionMasks.clear();
+	animationCollisionMasks.clear();
+
 	//clear all textures and sprites
 	while(!textureReferences.empty())
 	{
@@ -330,6 +1364,8 @@ void ShutdownTextures()
 		delete(*animationReferences.begin()).second;
         animationReferences.erase(animationReferences.begin());
 	}
+
+	textureReferenceGeneration++;
 }
 
 
@@ -3,6 +3,8 @@
 
 #include "StringUtil.h"
 #include "Animation.h"
+#include "PaletteSwap.h"
+#include "CollisionMask.h"
 
 /**
 *    Textures.h
@@ -31,19 +33,40 @@ void InitializeTextures(SDL_Renderer* renderer);
 */
 void ShutdownTextures();
 
+/**
+*	Return a number that changes whenever sprite, animation or texture references are
+*	replaced or freed. Code that keeps pointers to references compares it with the value
+*	it saw last to know when to look them up again.
+*
+* @return unsigned int The current generation of the references
+*/
+unsigned int GetTextureReferenceGeneration();
+
 /**
 *	Load a file with animation or sprite data. The image file name and data file name must match.
 *	Files are tab delimited and each line follows one of the following three formats
 *
 *	Sprite							reference	width	height	x	y
+*	Nine-Slice Sprite				reference	width	height	x	y	left	top	right	bottom
 *	First Animation Frame			reference	frameNumber	width	height	x	y	AnimationType	frameDelay
 *	Additional Animation Frame		reference	frameNumber	width	height	x	y
 * 
 * @param fileName The path and name of the file 
 * @param reference The unique name to refer to the file as
 * @param renderer A pointer to the SDL_Renderer to be used for rendering this file
+* @param collisionMasks Whether to build a collision mask for every sprite and animation frame of the file
 */
-void LoadFile(const String& fileName, const String& reference, SDL_Renderer* renderer);
+void LoadFile(const String& fileName, const String& reference, SDL_Renderer* renderer, bool collisionMasks = false);
+
+/**
+* Processes every line of a text data file already in memory, such as one in the asset archive
+* 
+* @param data The text of the file
+* @param size The number of bytes of text
+* @param reference The unique name of the file reference to store the lines
+* @return bool True if the file was processed correctly; false if there was an error
+*/
+bool ProcessTextData(const char* data, int size, const String& reference);
 
 /**
 * Prepares a text data file for line processing by removing any '\n' character
@@ -65,14 +88,41 @@ bool ProcessAndroidTextFile(SDL_RWops* rw, const String& reference);
 bool ProcessFileLine(const String& line, const String& reference);
 
 /**
-* Add an image file to be stored
+*	The gap left between parts of an image packed onto tiles
+*/
+const int TilePadding = 1;
+
+/**
+* Add an image file to be stored. Images larger than the renderer's maximum texture size
+* are split into tiles stored under reference#0, reference#1, ... and the sprite and
+* animation references already added for the file are moved onto them, so GetTexture and
+* the source rect functions keep working unchanged.
+* 
+* When collisionMasks is set the file's alpha is kept as a 1 bit mask, and every sprite
+* and animation frame of the file, added before or after, gets its own collision mask.
 * 
 * @param fileName The path and name of the file 
 * @param reference The unique name to refer to the file as
 * @param renderer A pointer to the SDL_Renderer to be used for rendering this file
+* @param collisionMasks Whether to build collision masks for the file's sprites and animations
 * @return bool True if the texture was generated and added; false if there was an error
 */
-bool AddFileReference(const String& fileName, const String& reference, SDL_Renderer* renderer);
+bool AddFileReference(const String& fileName, const String& reference, SDL_Renderer* renderer, bool collisionMasks = false);
+
+/**
+* Split an image that is too large for a single texture. If sprites or animations were
+* already added for the reference their rects are packed onto as few tiles as possible,
+* keeping every frame of an animation on one tile. Otherwise the image is cut into a grid
+* and sprites or animations added later are placed on the tile that holds them.
+*
+* @param surface The loaded image
+* @param reference The unique name to refer to the file as
+* @param renderer A pointer to the SDL_Renderer to be used for rendering this file
+* @param maxWidth The maximum texture width of the renderer
+* @param maxHeight The maximum texture height of the renderer
+* @return bool True if the tiles were generated and added; false if there was an error
+*/
+bool AddTiledFileReference(SDL_Surface* surface, const String& reference, SDL_Renderer* renderer, int maxWidth, int maxHeight);
 
 /**
 *    Add animation information of an animation stored on prereferenced file. If the 
@@ -106,6 +156,18 @@ void AddAnimationReference(const String& fileReference, String animationReferenc
 */
 void AddSpriteReference(const String& fileReference, String spriteReference, int width, int height, int x, int y);
 
+/**
+*    Mark a sprite as nine-slice. The borders keep their size when the sprite is drawn with
+*    DrawNineSliceSprite and the rest stretches, so a small panel can be drawn at any size.
+*
+* @param spriteReference The unique name given to the sprite
+* @param left The width of the left border in pixels
+* @param top The height of the top border in pixels
+* @param right The width of the right border in pixels
+* @param bottom The height of the bottom border in pixels
+*/
+void SetSpriteNineSlice(const String& spriteReference, int left, int top, int right, int bottom);
+
 /**
 *	Called by GetTexture. Gets the texture file stored under the given fileReference
 *
@@ -114,6 +176,15 @@ void AddSpriteReference(const String& fileReference, String spriteReference, int
 */
 SDL_Texture* GetTextureFileReference(const String& textureReference);
 
+/**
+*	Return the file reference a texture is stored under. Used by the draw trace to name
+*	textures it first sees in a draw call; this searches every texture so keep it off hot paths.
+*
+* @param texture The texture to find
+* @return String The file reference, an empty string if the texture was not loaded from a file
+*/
+String FindTextureFileReferenceName(SDL_Texture* texture);
+
 /**
 *	Return the SDL_Texture pointer stored under the given reference
 *
@@ -144,11 +215,80 @@ SpriteReference* GetSpriteReference(const String& spriteReference);
 *	Fills a supplied SDL_Rect pointer with the location of the given animationReference and frame
 *
 * @param animationReference The animationReference to get location information for
-* @param frame The frame number to get
+* @param frame The frame number to get, clamped to the first and last frames
 * @param source A pointer to the SDL_Rect to fill
 */
 void SetAnimationSourceRect(const String& animationReference, const int frame, SDL_Rect* source);
 
+/**
+*	Set how long a single animation frame is shown. The animation's clip is compiled again
+*	right away, so a pointer kept from GetAnimationClip sees the change.
+*
+* @param animationReference The unique name given to the animation
+* @param frame The frame number
+* @param duration The time to show the frame, in the same units as frameDelay; 0 to use frameDelay
+*/
+void SetAnimationFrameDuration(const String& animationReference, int frame, float duration);
+
+/**
+*	Set the event reported by GetAnimationClipEvents when a frame is reached. The animation's
+*	clip is compiled again right away.
+*
+* @param animationReference The unique name given to the animation
+* @param frame The frame number
+* @param event The event number, 0 for none
+*/
+void SetAnimationFrameEvent(const String& animationReference, int frame, int event);
+
+/**
+*	Compile the clip of every animation whose frames changed. LoadFile calls this once the
+*	file is loaded, and GetAnimationClip compiles a changed animation when it is asked for.
+*/
+void CompileAnimationClips();
+
+/**
+*	Return the compiled clip of an animation. Keep the pointer and play the clip with the
+*	functions below rather than working out PingPong and OneShot ordering per instance.
+*	The pointer stays valid until ShutdownTextures. Frames added to the animation after
+*	this are only in the clip once CompileAnimationClips or GetAnimationClip is called.
+*
+* @param animationReference The unique name given to the animation
+* @return const AnimationClip* The clip, nullptr if the animation was not found
+*/
+const AnimationClip* GetAnimationClip(const String& animationReference);
+
+/**
+*	Return the step of a clip shown at a time. Looping clips wrap the time, OneShot clips
+*	hold their last step, and the step is found without branching on the time.
+*
+* @param clip The clip from GetAnimationClip
+* @param time The time since the clip started, in the same units as frameDelay
+* @return int The step, an index into the clip's rects and events
+*/
+int GetAnimationClipStep(const AnimationClip& clip, float time);
+
+/**
+*	Fills a supplied SDL_Rect pointer with the source rect of a clip at a time
+*
+* @param clip The clip from GetAnimationClip
+* @param time The time since the clip started, in the same units as frameDelay
+* @param source A pointer to the SDL_Rect to fill
+*/
+void SetAnimationClipSourceRect(const AnimationClip& clip, float time, SDL_Rect* source);
+
+/**
+*	Fills a supplied vector with the events of the steps reached after previousTime up to
+*	and including time. At most one pass of the clip is reported for a long jump. Pass a
+*	negative previousTime on the first update so the first step's event is reported.
+*
+* @param clip The clip from GetAnimationClip
+* @param previousTime The time of the last update, negative if the clip is just starting
+* @param time The time of this update
+* @param events The vector to fill; it is cleared first
+* @return int The number of events found
+*/
+int GetAnimationClipEvents(const AnimationClip& clip, float previousTime, float time, std::vector<int>& events);
+
 /**
 *	Fills a supplied SDL_Rect pointer with the location of the given spriteReference
 *
@@ -157,6 +297,99 @@ void SetAnimationSourceRect(const String& animationReference, const int frame, S
 */
 void SetSpriteSourceRect(const String& spriteReference, SDL_Rect* source);
 
+/**
+*	Return the collision mask of a sprite whose file was loaded with collision masks
+*
+* @param spriteReference The unique name given to the sprite
+* @return const CollisionMask* The mask, nullptr if the sprite has none
+*/
+const CollisionMask* GetSpriteCollisionMask(const String& spriteReference);
+
+/**
+*	Return the collision mask of an animation frame whose file was loaded with collision masks
+*
+* @param animationReference The unique name given to the animation
+* @param frame The frame number, wrapped to the animation's frames
+* @return const CollisionMask* The mask, nullptr if the animation has none
+*/
+const CollisionMask* GetAnimationCollisionMask(const String& animationReference, int frame);
+
+/**
+*	Register a recolored variant of a loaded file. The variant's texture is made from the
+*	original image the first time it is used and then cached. Every sprite and animation
+*	of the file is copied under "reference@variant" with the same rects, so draw the
+*	variant with GetTexture(TextureType_Sprite, "Bubble@Blue"). Collision masks are shared
+*	with the copies. Register variants after
+*	the file's sprites and animations are added. Files split into tiles are not supported.
+*
+* @param fileReference The unique name given to the file
+* @param variant The name of the variant, added to each reference after an '@'
+* @param swaps The colors to replace
+* @param renderer A pointer to the SDL_Renderer used to create the variant's texture
+* @return bool True if the variant was registered; false if the file cannot be recolored
+*/
+bool RegisterPaletteVariant(const String& fileReference, const String& variant, const std::vector<PaletteSwap>& swaps,
+							SDL_Renderer* renderer);
+
+/**
+*	Draw part of a texture into any size keeping the borders unstretched. The corners are
+*	copied as they are, the edges stretch along their length and the center fills the
+*	rest. When the destination is smaller than the borders they shrink to fit. Each of
+*	the nine copies is recorded by the draw trace and replayed.
+*
+* @param renderer The renderer to draw too
+* @param texture The texture holding the source
+* @param source The part of the texture to draw
+* @param left The width of the left border in pixels
+* @param top The height of the top border in pixels
+* @param right The width of the right border in pixels
+* @param bottom The height of the bottom border in pixels
+* @param destination Where to draw and at what size
+*/
+void DrawNineSlice(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* source,
+					int left, int top, int right, int bottom, const SDL_Rect* destination);
+
+/**
+*	Draw a nine-slice sprite at any size. A sprite with no slice is stretched whole.
+*
+* @param renderer The renderer to draw too
+* @param spriteReference The unique name given to the sprite
+* @param destination Where to draw and at what size
+*/
+void DrawNineSliceSprite(SDL_Renderer* renderer, const String& spriteReference, const SDL_Rect* destination);
+
+/**
+*	Draw a whole file at position x, y. Files that were split into a grid of tiles are
+*	drawn tile by tile so large backgrounds work on any renderer.
+*
+* @param renderer The renderer to draw too
+* @param fileReference The unique name given to the file
+* @param x The x coordinate to draw too
+* @param y The y coordinate to draw too
+*/
+void DrawFileReference(SDL_Renderer* renderer, const String& fileReference, int x, int y);
+
+/**
+*	Store the textures of the given file references in slots so they can be recalled by
+*	index. Used by the header written by tools/SpriteIdGenerator; call again after the
+*	files are reloaded. A file that was split into tiles is left unbound, since the
+*	generated rects no longer match any one texture, and must be drawn by name.
+*
+* @param fileReferences The unique names given to the files, in slot order, kept until
+*	the slots are bound again
+* @param count The number of file references
+*/
+void BindTextureFileSlots(const char* const* fileReferences, int count);
+
+/**
+*	Return the texture stored in the given slot by BindTextureFileSlots
+*
+* @param slot The slot index
+* @return SDL_Texture* A pointer to the SDL_Texture in the slot, nullptr with a warning if
+*	the slot's file was tiled or not found
+*/
+SDL_Texture* GetTextureFileSlot(int slot);
+
 
 
 
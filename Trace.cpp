@@ -0,0 +1,208 @@
+#include "stdafx.h"
+
+#include "Trace.h"
+#include "SDLUtil.h"
+
+#include <atomic>
+#include <mutex>
+#include <fstream>
+#include <iomanip>
+#include <string.h>
+
+/**
+*    Trace.cpp
+*
+*	This file has the per thread ring buffers behind the trace markers. A thread only
+*	writes to its own buffer so recording needs no locks; the global list of buffers is
+*	only locked when a thread records its first event and when exporting.
+*/
+
+struct TraceEvent
+{
+	const char* name;
+	unsigned long long start;
+	unsigned long long duration;
+	long long bytes;
+	char asset[TraceAssetLength];
+};
+
+struct TraceBuffer
+{
+	TraceEvent events[TraceBufferSize];
+	std::atomic<unsigned int> count;
+	int threadId;
+};
+
+std::atomic<bool> tracingEnabled(false);
+std::vector<TraceBuffer*> traceBuffers;
+std::mutex traceBufferMutex;
+
+//moved on by ShutdownTracing so threads drop the buffers it freed
+std::atomic<unsigned int> traceGeneration(1);
+
+thread_local TraceBuffer* threadTraceBuffer = nullptr;
+thread_local unsigned int threadTraceGeneration = 0;
+
+static TraceBuffer* GetThreadTraceBuffer()
+{
+	unsigned int generation = traceGeneration.load(std::memory_order_acquire);
+	if(!threadTraceBuffer || threadTraceGeneration != generation)
+	{
+		TraceBuffer* buffer = new TraceBuffer();
+		buffer->count = 0;
+
+		std::lock_guard<std::mutex> lock(traceBufferMutex);
+		buffer->threadId = (int)traceBuffers.size() + 1;
+		traceBuffers.push_back(buffer);
+		threadTraceBuffer = buffer;
+		threadTraceGeneration = generation;
+	}
+
+	return threadTraceBuffer;
+}
+
+void SetTracingEnabled(bool enabled)
+{
+	tracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool IsTracingEnabled()
+{
+	return tracingEnabled.load(std::memory_order_relaxed);
+}
+
+TraceScope::TraceScope(const char* name, const char* asset)
+{
+	mName = name;
+	mAsset = asset;
+	mBytes = -1;
+	mStart = IsTracingEnabled() ? SDL_GetPerformanceCounter() : 0;
+}
+
+TraceScope::~TraceScope()
+{
+	//tracing was off when the scope started
+	if(mStart == 0)
+		return;
+
+	unsigned long long end = SDL_GetPerformanceCounter();
+	TraceBuffer* buffer = GetThreadTraceBuffer();
+	unsigned int index = buffer->count.load(std::memory_order_relaxed);
+	TraceEvent& e = buffer->events[index % TraceBufferSize];
+
+	e.name = mName;
+	e.start = mStart;
+	e.duration = end - mStart;
+	e.bytes = mBytes;
+	e.asset[0] = '\0';
+
+	if(mAsset)
+	{
+		//keep the end of long paths since the file name is the useful part
+		size_t length = strlen(mAsset);
+		const char* asset = length < TraceAssetLength ? mAsset : mAsset + length - (TraceAssetLength - 1);
+		strncpy(e.asset, asset, TraceAssetLength - 1);
+		e.asset[TraceAssetLength - 1] = '\0';
+	}
+
+	buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void ClearTrace()
+{
+	std::lock_guard<std::mutex> lock(traceBufferMutex);
+
+	for(size_t i = 0; i < traceBuffers.size(); i++)
+		traceBuffers[i]->count.store(0);
+}
+
+static void WriteJSONString(std::ostream& os, const char* s)
+{
+	os << '"';
+	for(; *s; s++)
+	{
+		if(*s == '"' || *s == '\\')
+			os << '\\' << *s;
+		else if((unsigned char)*s < 0x20)
+			os << ' ';
+		else
+			os << *s;
+	}
+	os << '"';
+}
+
+bool ExportChromeTrace(const String& fileName)
+{
+	std::ofstream file(fileName.c_str());
+
+	if(!file.is_open())
+	{
+		logError(std::cout, "ExportChromeTrace: error opening: " + fileName);
+		return false;
+	}
+
+	double microseconds = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+	bool first = true;
+
+	//timestamps are large so print them in full rather than in exponent form
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	std::lock_guard<std::mutex> lock(traceBufferMutex);
+
+	for(size_t b = 0; b < traceBuffers.size(); b++)
+	{
+		TraceBuffer* buffer = traceBuffers[b];
+		unsigned int count = buffer->count.load(std::memory_order_acquire);
+		unsigned int start = count > (unsigned int)TraceBufferSize ? count - TraceBufferSize : 0;
+
+		for(unsigned int i = start; i < count; i++)
+		{
+			const TraceEvent& e = buffer->events[i % TraceBufferSize];
+
+			file << (first ? "\n" : ",\n") << "{\"name\":";
+			WriteJSONString(file, e.name);
+			file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+				<< ",\"ts\":" << (double)e.start * microseconds
+				<< ",\"dur\":" << (double)e.duration * microseconds;
+
+			if(e.asset[0] != '\0' || e.bytes >= 0)
+			{
+				file << ",\"args\":{";
+				if(e.asset[0] != '\0')
+				{
+					file << "\"asset\":";
+					WriteJSONString(file, e.asset);
+				}
+				if(e.bytes >= 0)
+					file << (e.asset[0] != '\0' ? "," : "") << "\"bytes\":" << e.bytes;
+				file << "}";
+			}
+
+			file << "}";
+			first = false;
+		}
+	}
+
+	file << "\n]}\n";
+	file.close();
+
+	return true;
+}
+
+void ShutdownTracing()
+{
+	SetTracingEnabled(false);
+
+	std::lock_guard<std::mutex> lock(traceBufferMutex);
+
+	//threads that recorded still hold their buffer, the new generation makes them start another
+	traceGeneration.fetch_add(1, std::memory_order_release);
+
+	while(!traceBuffers.empty())
+	{
+		delete traceBuffers.back();
+		traceBuffers.pop_back();
+	}
+	threadTraceBuffer = nullptr;
+}
@@ -0,0 +1,106 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "StringUtil.h"
+
+/**
+*    Trace.h
+*
+*	This file has the scoped trace markers used to find where load and frame time goes.
+*	Build with ENABLE_TRACING defined to compile the markers in, then turn recording on
+*	and off at runtime with SetTracingEnabled. Each thread records into its own ring
+*	buffer that keeps the most recent events, and ExportChromeTrace writes every buffer
+*	as Chrome trace-event JSON that can be opened in chrome://tracing or Perfetto.
+*
+*	Without ENABLE_TRACING the macros compile to nothing, including their arguments. The
+*	asset given to TRACE_SCOPE_ASSET must outlive the scope; it is copied when the scope ends.
+*
+*		void LoadSomething(const String& file)
+*		{
+*			TRACE_SCOPE_ASSET("LoadSomething", file);
+*			...
+*			TRACE_BYTES(size);
+*		}
+*/
+
+#ifdef ENABLE_TRACING
+	#define TRACE_SCOPE(name) TraceScope traceScope(name)
+	#define TRACE_SCOPE_ASSET(name, asset) TraceScope traceScope(name, (asset).c_str())
+	#define TRACE_BYTES(bytes) traceScope.SetBytes(bytes)
+#else
+	#define TRACE_SCOPE(name)
+	#define TRACE_SCOPE_ASSET(name, asset)
+	#define TRACE_BYTES(bytes) ((void)0)
+#endif
+
+/**
+*	The number of events each thread keeps before the oldest are overwritten
+*/
+const int TraceBufferSize = 8192;
+
+/**
+*	The longest asset name stored with an event, longer names keep their end
+*/
+const int TraceAssetLength = 48;
+
+/**
+*	Turn recording on or off. Markers cost a single flag check while off.
+*
+* @param enabled Whether to record events
+*/
+void SetTracingEnabled(bool enabled);
+
+/**
+*	Return whether events are being recorded
+*/
+bool IsTracingEnabled();
+
+/**
+*	Discard every recorded event on every thread
+*/
+void ClearTrace();
+
+/**
+*	Write every recorded event as Chrome trace-event JSON. Events still being written by
+*	other threads while exporting may be skipped.
+*
+* @param fileName The path and name of the file to write
+* @return bool True if the file was written; false if there was an error
+*/
+bool ExportChromeTrace(const String& fileName);
+
+/**
+*	Free the buffers of every thread. Call once before shutting down the game. Threads
+*	that recorded before this start a new buffer if tracing is turned on again, but no
+*	thread may be inside a trace scope while this runs, so join the loading threads first.
+*/
+void ShutdownTracing();
+
+/**
+*	Scoped marker used by the TRACE_ macros. Records one complete event from
+*	construction to destruction on the current thread.
+*/
+class TraceScope
+{
+public:
+	TraceScope(const char* name, const char* asset = nullptr);
+	~TraceScope();
+
+	/**
+	*	Attach a byte size to the event
+	*
+	* @param bytes The number of bytes loaded or created inside the scope
+	*/
+	void SetBytes(long long bytes)
+	{
+		mBytes = bytes;
+	}
+
+private:
+	const char* mName;
+	const char* mAsset;
+	unsigned long long mStart;
+	long long mBytes;
+};
+
+#endif //TRACE_H
@@ -0,0 +1,102 @@
+/**
+*    DrawTraceReplay.cpp
+*
+*	Benchmark tool that replays a draw trace recorded with StartDrawTraceRecording against
+*	the software renderer and prints frame time percentiles. Nothing is shown on screen,
+*	so runs are not tied to the display refresh rate. Run it from the game's directory so
+*	InitializeTextures finds the same images the trace was recorded with:
+*
+*		DrawTraceReplay session.dtrace [runs]
+*
+*	Build it with the game's sources except the file that has main.
+*/
+
+#include "stdafx.h"
+
+#include "SDLUtil.h"
+#include "Textures.h"
+#include "DrawTrace.h"
+#include "Fonts.h"
+#include "AsyncLog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+static double Percentile(const std::vector<double>& sorted, double percent)
+{
+	if(sorted.empty())
+		return 0.0;
+
+	size_t index = (size_t)(percent / 100.0 * (double)(sorted.size() - 1) + 0.5);
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 2)
+	{
+		printf("usage: DrawTraceReplay trace.dtrace [runs]\n");
+		return 1;
+	}
+
+	int runs = argc > 2 ? atoi(argv[2]) : 1;
+	if(runs < 1)
+		runs = 1;
+
+	if(SDL_Init(0) != 0 || TTF_Init() != 0)
+	{
+		logSDLError(std::cout, "SDL_Init");
+		return 1;
+	}
+	IMG_Init(IMG_INIT_PNG);
+
+	SDL_Surface* target = SDL_CreateRGBSurface(0, LogicalWidth, LogicalHeight, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+	SDL_Renderer* renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+	if(!renderer)
+	{
+		logSDLError(std::cout, "CreateSoftwareRenderer");
+		return 1;
+	}
+
+	InitializeTextures(renderer);
+
+	std::vector<double> frameTimes;
+	std::vector<double> allFrameTimes;
+
+	for(int run = 0; run < runs; run++)
+	{
+		if(!ReplayDrawTrace(argv[1], renderer, frameTimes))
+			return 1;
+
+		allFrameTimes.insert(allFrameTimes.end(), frameTimes.begin(), frameTimes.end());
+	}
+
+	std::sort(allFrameTimes.begin(), allFrameTimes.end());
+
+	double total = 0.0;
+	for(size_t i = 0; i < allFrameTimes.size(); i++)
+		total += allFrameTimes[i];
+
+	printf("frames %u runs %d\n", (unsigned int)allFrameTimes.size(), runs);
+	if(!allFrameTimes.empty())
+	{
+		printf("mean %.3f ms\n", total / (double)allFrameTimes.size());
+		printf("p50 %.3f ms\n", Percentile(allFrameTimes, 50.0));
+		printf("p90 %.3f ms\n", Percentile(allFrameTimes, 90.0));
+		printf("p95 %.3f ms\n", Percentile(allFrameTimes, 95.0));
+		printf("p99 %.3f ms\n", Percentile(allFrameTimes, 99.0));
+		printf("max %.3f ms\n", allFrameTimes.back());
+	}
+
+	ShutdownTextures();
+	ShutdownFonts();
+	ShutdownAsyncLog();
+	SDL_DestroyRenderer(renderer);
+	SDL_FreeSurface(target);
+	IMG_Quit();
+	TTF_Quit();
+	SDL_Quit();
+
+	return 0;
+}
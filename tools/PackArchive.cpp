@@ -0,0 +1,145 @@
+/**
+*    PackArchive.cpp
+*
+*	Build time tool that packs asset files into one archive for OpenAssetArchive. Name
+*	each file by the path the game loads it with, relative to the game's directory:
+*
+*		PackArchive assets.pak image/sprites.png image/sprites.txt image/ui.qoi font/main.ttf
+*
+*	Files are stored whole in the order given, each aligned to ArchiveAlignment bytes.
+*	The format is described in Archive.h and the constants below must match it.
+*
+*	This tool only uses the standard library so it can be built and run before the game.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <fstream>
+
+typedef std::string String;
+
+const unsigned int ArchiveAlignment = 16;
+const unsigned int ArchiveVersion = 1;
+
+struct PackEntry
+{
+	String name;
+	std::vector<char> data;
+	unsigned int offset;
+};
+
+static void Write32(std::vector<char>& out, unsigned int value)
+{
+	out.push_back((char)(value & 0xff));
+	out.push_back((char)((value >> 8) & 0xff));
+	out.push_back((char)((value >> 16) & 0xff));
+	out.push_back((char)((value >> 24) & 0xff));
+}
+
+static void Align(std::vector<char>& out)
+{
+	while(out.size() % ArchiveAlignment != 0)
+		out.push_back(0);
+}
+
+static bool ReadWholeFile(const String& fileName, std::vector<char>& data)
+{
+	std::ifstream file(fileName.c_str(), std::ios::binary);
+	if(!file.is_open())
+		return false;
+
+	data.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 3)
+	{
+		printf("usage: PackArchive archive.pak file [more files]\n");
+		return 1;
+	}
+
+	std::vector<PackEntry> entries;
+	std::set<String> names;
+
+	for(int i = 2; i < argc; i++)
+	{
+		PackEntry entry;
+		entry.name = argv[i];
+		for(size_t c = 0; c < entry.name.length(); c++)
+			if(entry.name[c] == '\\')
+				entry.name[c] = '/';
+
+		if(!names.insert(entry.name).second)
+		{
+			fprintf(stderr, "error: %s is listed twice\n", entry.name.c_str());
+			return 1;
+		}
+
+		if(!ReadWholeFile(argv[i], entry.data))
+		{
+			fprintf(stderr, "error: could not read %s\n", argv[i]);
+			return 1;
+		}
+
+		entries.push_back(entry);
+	}
+
+	std::vector<char> index;
+	for(size_t i = 0; i < entries.size(); i++)
+	{
+		//offsets are filled in once the index size is known
+		Write32(index, 0);
+		Write32(index, (unsigned int)entries[i].data.size());
+		Write32(index, (unsigned int)entries[i].name.length());
+		index.insert(index.end(), entries[i].name.begin(), entries[i].name.end());
+	}
+
+	std::vector<char> out;
+	out.push_back('C');
+	out.push_back('D');
+	out.push_back('P');
+	out.push_back('K');
+	Write32(out, ArchiveVersion);
+	Write32(out, (unsigned int)entries.size());
+	Write32(out, (unsigned int)index.size());
+	size_t indexStart = out.size();
+	out.insert(out.end(), index.begin(), index.end());
+
+	size_t indexPosition = indexStart;
+	for(size_t i = 0; i < entries.size(); i++)
+	{
+		Align(out);
+		entries[i].offset = (unsigned int)out.size();
+		out.insert(out.end(), entries[i].data.begin(), entries[i].data.end());
+
+		std::vector<char> offset;
+		Write32(offset, entries[i].offset);
+		memcpy(&out[indexPosition], &offset[0], 4);
+		indexPosition += 12 + entries[i].name.length();
+	}
+
+	if(out.size() >= 0x7FFFFFFF)
+	{
+		fprintf(stderr, "error: the archive is larger than 2GB\n");
+		return 1;
+	}
+
+	std::ofstream file(argv[1], std::ios::binary | std::ios::trunc);
+	if(!file.is_open())
+	{
+		fprintf(stderr, "error: could not write %s\n", argv[1]);
+		return 1;
+	}
+	file.write(&out[0], out.size());
+	file.close();
+
+	printf("packed %u files into %s (%u bytes)\n", (unsigned int)entries.size(), argv[1], (unsigned int)out.size());
+
+	return 0;
+}
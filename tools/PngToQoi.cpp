@@ -0,0 +1,68 @@
+/**
+*    PngToQoi.cpp
+*
+*	Build time tool that converts images to the QOI format. Each image is written next
+*	to the original with the extension changed to ".qoi", where LoadFile and
+*	AddFileReference pick it up in place of the original:
+*
+*		PngToQoi image/sprites.png image/ui.png image/CloudBox.png
+*
+*	Build it with Qoi.cpp and SDLUtil.cpp and link SDL2 and SDL2_image.
+*/
+
+#include "stdafx.h"
+
+#include "SDLUtil.h"
+#include "Qoi.h"
+
+#include <stdio.h>
+
+int main(int argc, char** argv)
+{
+	if(argc < 2)
+	{
+		printf("usage: PngToQoi image.png [more images]\n");
+		return 1;
+	}
+
+	if(SDL_Init(0) != 0)
+	{
+		logSDLError(std::cout, "SDL_Init");
+		return 1;
+	}
+	IMG_Init(IMG_INIT_PNG);
+
+	int failed = 0;
+
+	for(int i = 1; i < argc; i++)
+	{
+		String fileName = argv[i];
+		if(IsQoiFile(fileName) || fileName.length() < 4)
+		{
+			printf("skipping %s\n", fileName.c_str());
+			continue;
+		}
+
+		String qoiFileName = fileName.substr(0, fileName.length() - 4) + ".qoi";
+
+		SDL_Surface* surface = IMG_Load(fileName.c_str());
+		if(!surface)
+		{
+			logSDLError(std::cout, "IMG_Load " + fileName);
+			failed++;
+			continue;
+		}
+
+		if(SaveQoiSurface(surface, qoiFileName))
+			printf("%s -> %s\n", fileName.c_str(), qoiFileName.c_str());
+		else
+			failed++;
+
+		SDL_FreeSurface(surface);
+	}
+
+	IMG_Quit();
+	SDL_Quit();
+
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,568 @@
+/**
+*    SpriteIdGenerator.cpp
+*
+*	Build time tool that reads animation and sprite data files and writes a header of
+*	compile time ids and rect tables for them. Run it whenever a data file changes:
+*
+*		SpriteIdGenerator SpriteIds.h image/sprites.txt image/ui.txt Textures.cpp
+*
+*	The data files use the same tab delimited format read by LoadFile and each is referenced
+*	by its file name without the extension, the same way InitializeTextures names them.
+*	Source files (.cpp or .h) are scanned for AddSpriteReference and SetSpriteNineSlice
+*	calls whose arguments are all literals, so sprites registered in code such as
+*	"CloudBox" get ids as well. Calls with computed arguments are skipped.
+*	The generated header adds overloads of GetTexture, SetSpriteSourceRect,
+*	SetAnimationSourceRect and DrawNineSliceSprite that take a SpriteId or AnimationId
+*	instead of a string so a misspelled name fails to compile and the lookup is an array
+*	index. The overloads record to the draw trace under the string names, so a trace of
+*	frames drawn by id replays the same as one drawn by name.
+*
+*	This tool only uses the standard library so it can be built and run before the game.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+typedef std::string String;
+
+struct SpriteEntry
+{
+	String name;
+	int file;
+	int x, y, w, h;
+	int sliceLeft, sliceTop, sliceRight, sliceBottom;
+};
+
+struct AnimationEntry
+{
+	String name;
+	int file;
+	int w, h;
+	int animationType;
+	float frameDelay;
+	std::vector<std::pair<int, int> > frames;
+};
+
+std::vector<String> fileReferences;
+std::vector<String> fileNames;
+std::vector<SpriteEntry> sprites;
+std::vector<AnimationEntry> animations;
+
+static std::vector<String> SplitLine(const String& line)
+{
+	std::vector<String> values;
+	std::stringstream stream(line);
+	String value;
+
+	while(getline(stream, value, '\t'))
+		if(!value.empty())
+			values.push_back(value);
+
+	return values;
+}
+
+static String FileReference(const String& fileName)
+{
+	size_t slash = fileName.find_last_of("/\\");
+	String name = slash == String::npos ? fileName : fileName.substr(slash + 1);
+	size_t dot = name.find_last_of('.');
+
+	return dot == String::npos ? name : name.substr(0, dot);
+}
+
+static String Identifier(const String& name)
+{
+	String id;
+
+	for(size_t i = 0; i < name.length(); i++)
+		id += isalnum((unsigned char)name[i]) ? name[i] : '_';
+
+	return id;
+}
+
+static String Quoted(const String& s)
+{
+	String quoted = "\"";
+
+	for(size_t i = 0; i < s.length(); i++)
+	{
+		if(s[i] == '"' || s[i] == '\\')
+			quoted += '\\';
+		quoted += s[i];
+	}
+
+	return quoted + "\"";
+}
+
+static String FloatLiteral(float f)
+{
+	std::stringstream stream;
+	stream << f;
+	String literal = stream.str();
+
+	if(literal.find_first_of(".e") == String::npos)
+		literal += ".0";
+
+	return literal + "f";
+}
+
+static AnimationEntry* FindAnimation(const String& name)
+{
+	for(size_t i = 0; i < animations.size(); i++)
+		if(animations[i].name == name)
+			return &animations[i];
+
+	return nullptr;
+}
+
+static bool ReadDataFile(const String& fileName)
+{
+	std::ifstream file(fileName.c_str());
+
+	if(!file.is_open())
+	{
+		fprintf(stderr, "SpriteIdGenerator: error opening: %s\n", fileName.c_str());
+		return false;
+	}
+
+	int fileIndex = (int)fileReferences.size();
+	fileReferences.push_back(FileReference(fileName));
+	fileNames.push_back(fileName);
+
+	String line;
+	int lineNumber = 0;
+
+	while(getline(file, line))
+	{
+		lineNumber++;
+
+		//files written on Windows keep the '\r' when read here
+		if(!line.empty() && line[line.length() - 1] == '\r')
+			line.erase(line.length() - 1);
+
+		std::vector<String> v = SplitLine(line);
+
+		if(v.empty())
+			continue;
+
+		//the same field counts ProcessFileLine accepts
+		if(v.size() == 8 || v.size() == 6)
+		{
+			AnimationEntry* a = FindAnimation(v[0]);
+			if(!a)
+			{
+				AnimationEntry entry;
+				entry.name = v[0];
+				entry.file = fileIndex;
+				entry.w = atoi(v[2].c_str());
+				entry.h = atoi(v[3].c_str());
+				entry.animationType = v.size() == 8 ? atoi(v[6].c_str()) : 0;
+				entry.frameDelay = v.size() == 8 ? (float)atof(v[7].c_str()) : 0.0f;
+				animations.push_back(entry);
+				a = &animations.back();
+			}
+			a->frames.push_back(std::make_pair(atoi(v[4].c_str()), atoi(v[5].c_str())));
+		}
+		else if(v.size() == 5 || v.size() == 9)
+		{
+			SpriteEntry s;
+			s.name = v[0];
+			s.file = fileIndex;
+			s.w = atoi(v[1].c_str());
+			s.h = atoi(v[2].c_str());
+			s.x = atoi(v[3].c_str());
+			s.y = atoi(v[4].c_str());
+			s.sliceLeft = v.size() == 9 ? atoi(v[5].c_str()) : 0;
+			s.sliceTop = v.size() == 9 ? atoi(v[6].c_str()) : 0;
+			s.sliceRight = v.size() == 9 ? atoi(v[7].c_str()) : 0;
+			s.sliceBottom = v.size() == 9 ? atoi(v[8].c_str()) : 0;
+			sprites.push_back(s);
+		}
+		else
+		{
+			fprintf(stderr, "%s(%d): error: expected 5, 6, 8 or 9 tab separated values\n", fileName.c_str(), lineNumber);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+*	Strip comments so commented out registrations are not picked up, keeping string literals
+*/
+static String StripComments(const String& source)
+{
+	String stripped;
+	size_t i = 0;
+
+	while(i < source.length())
+	{
+		if(source.compare(i, 2, "//") == 0)
+		{
+			while(i < source.length() && source[i] != '\n')
+				i++;
+		}
+		else if(source.compare(i, 2, "/*") == 0)
+		{
+			size_t end = source.find("*/", i + 2);
+			i = end == String::npos ? source.length() : end + 2;
+			stripped += ' ';
+		}
+		else if(source[i] == '"' || source[i] == '\'')
+		{
+			//character literals are skipped too so '"' does not start a string
+			char quote = source[i];
+			size_t start = i++;
+			while(i < source.length() && source[i] != quote)
+				i += source[i] == '\\' ? 2 : 1;
+			i++;
+			stripped += source.substr(start, std::min(i, source.length()) - start);
+		}
+		else
+			stripped += source[i++];
+	}
+
+	return stripped;
+}
+
+/**
+*	Reads the literal arguments of a call one at a time, failing on anything computed
+*/
+struct CallReader
+{
+	const String& source;
+	size_t at;
+
+	CallReader(const String& s, size_t start) : source(s), at(start) {}
+
+	void SkipSpace()
+	{
+		while(at < source.length() && isspace((unsigned char)source[at]))
+			at++;
+	}
+
+	bool Expect(char c)
+	{
+		SkipSpace();
+		if(at >= source.length() || source[at] != c)
+			return false;
+		at++;
+		return true;
+	}
+
+	bool Quoted(String& value)
+	{
+		if(!Expect('"'))
+			return false;
+
+		value.clear();
+		while(at < source.length() && source[at] != '"')
+		{
+			if(source[at] == '\\' && at + 1 < source.length())
+				at++;
+			value += source[at++];
+		}
+
+		return Expect('"');
+	}
+
+	bool Integer(int& value)
+	{
+		SkipSpace();
+		size_t start = at;
+		if(at < source.length() && source[at] == '-')
+			at++;
+		while(at < source.length() && isdigit((unsigned char)source[at]))
+			at++;
+		if(at == start || (at == start + 1 && source[start] == '-'))
+			return false;
+
+		value = atoi(source.substr(start, at - start).c_str());
+		return true;
+	}
+};
+
+/**
+*	Return the position just past "name(" for each call of the function in the source
+*/
+static std::vector<size_t> FindCalls(const String& source, const String& name)
+{
+	std::vector<size_t> calls;
+	size_t at = 0;
+
+	while((at = source.find(name, at)) != String::npos)
+	{
+		size_t end = at + name.length();
+		bool wholeName = at == 0 || !(isalnum((unsigned char)source[at - 1]) || source[at - 1] == '_');
+		at = end;
+
+		CallReader reader(source, end);
+		if(wholeName && reader.Expect('('))
+			calls.push_back(reader.at);
+	}
+
+	return calls;
+}
+
+static int FindFileReference(const String& reference, const String& fileName)
+{
+	for(size_t i = 0; i < fileReferences.size(); i++)
+		if(fileReferences[i] == reference)
+			return (int)i;
+
+	fileReferences.push_back(reference);
+	fileNames.push_back(fileName + " (" + reference + ")");
+
+	return (int)fileReferences.size() - 1;
+}
+
+static bool ReadSourceFile(const String& fileName)
+{
+	std::ifstream file(fileName.c_str());
+
+	if(!file.is_open())
+	{
+		fprintf(stderr, "SpriteIdGenerator: error opening: %s\n", fileName.c_str());
+		return false;
+	}
+
+	std::stringstream contents;
+	contents << file.rdbuf();
+	String source = StripComments(contents.str());
+
+	//AddSpriteReference(fileReference, spriteReference, width, height, x, y)
+	std::vector<size_t> calls = FindCalls(source, "AddSpriteReference");
+	for(size_t i = 0; i < calls.size(); i++)
+	{
+		CallReader reader(source, calls[i]);
+		String fileReference;
+		SpriteEntry s;
+
+		if(!reader.Quoted(fileReference) || !reader.Expect(',') || !reader.Quoted(s.name) || !reader.Expect(',') ||
+		   !reader.Integer(s.w) || !reader.Expect(',') || !reader.Integer(s.h) || !reader.Expect(',') ||
+		   !reader.Integer(s.x) || !reader.Expect(',') || !reader.Integer(s.y) || !reader.Expect(')'))
+			continue;
+
+		s.file = FindFileReference(fileReference, fileName);
+		s.sliceLeft = s.sliceTop = s.sliceRight = s.sliceBottom = 0;
+		sprites.push_back(s);
+	}
+
+	//SetSpriteNineSlice(spriteReference, left, top, right, bottom)
+	calls = FindCalls(source, "SetSpriteNineSlice");
+	for(size_t i = 0; i < calls.size(); i++)
+	{
+		CallReader reader(source, calls[i]);
+		String name;
+		int left, top, right, bottom;
+
+		if(!reader.Quoted(name) || !reader.Expect(',') || !reader.Integer(left) || !reader.Expect(',') ||
+		   !reader.Integer(top) || !reader.Expect(',') || !reader.Integer(right) || !reader.Expect(',') ||
+		   !reader.Integer(bottom) || !reader.Expect(')'))
+			continue;
+
+		for(size_t j = 0; j < sprites.size(); j++)
+		{
+			if(sprites[j].name == name)
+			{
+				sprites[j].sliceLeft = left;
+				sprites[j].sliceTop = top;
+				sprites[j].sliceRight = right;
+				sprites[j].sliceBottom = bottom;
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool IsSourceFile(const String& fileName)
+{
+	size_t dot = fileName.find_last_of('.');
+	String extension = dot == String::npos ? "" : fileName.substr(dot);
+
+	return extension == ".cpp" || extension == ".h";
+}
+
+//two names that map to the same identifier would silently share an id
+static bool CheckUnique(const String& prefix, const std::vector<String>& names)
+{
+	std::set<String> seen;
+
+	for(size_t i = 0; i < names.size(); i++)
+	{
+		if(!seen.insert(Identifier(names[i])).second)
+		{
+			fprintf(stderr, "SpriteIdGenerator: error: duplicate %s%s\n", prefix.c_str(), Identifier(names[i]).c_str());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void WriteHeader(std::ostream& os)
+{
+	os << "#ifndef SPRITEIDS_H\n#define SPRITEIDS_H\n\n";
+	os << "#include \"Textures.h\"\n#include \"DrawTrace.h\"\n\n";
+	os << "/**\n*    SpriteIds.h\n*\n";
+	os << "*	Generated by tools/SpriteIdGenerator from the files below, do not edit.\n*\n";
+	for(size_t i = 0; i < fileNames.size(); i++)
+		os << "*	" << fileNames[i] << "\n";
+	os << "*\n*	Call BindSpriteIdTextures once after InitializeTextures.\n*/\n\n";
+
+	os << "enum SpriteFileId\n{\n";
+	for(size_t i = 0; i < fileReferences.size(); i++)
+		os << "\tSpriteFileId_" << Identifier(fileReferences[i]) << ",\n";
+	os << "\tSpriteFileId_Count\n};\n\n";
+
+	os << "enum SpriteId\n{\n";
+	for(size_t i = 0; i < sprites.size(); i++)
+		os << "\tSpriteId_" << Identifier(sprites[i].name) << ",\n";
+	os << "\tSpriteId_Count\n};\n\n";
+
+	os << "enum AnimationId\n{\n";
+	for(size_t i = 0; i < animations.size(); i++)
+		os << "\tAnimationId_" << Identifier(animations[i].name) << ",\n";
+	os << "\tAnimationId_Count\n};\n\n";
+
+	os << "struct SpriteIdRect\n{\n\tint file;\n\tint x;\n\tint y;\n\tint w;\n\tint h;\n"
+		<< "\tint sliceLeft;\n\tint sliceTop;\n\tint sliceRight;\n\tint sliceBottom;\n};\n\n";
+	os << "struct AnimationIdInfo\n{\n\tint file;\n\tint w;\n\tint h;\n\tint firstFrame;\n\tint frameCount;\n"
+		<< "\tint animationType;\n\tfloat frameDelay;\n};\n\n";
+	os << "struct AnimationIdFrame\n{\n\tint x;\n\tint y;\n};\n\n";
+
+	os << "static const char* const SpriteFileReferences[SpriteFileId_Count + 1] =\n{\n";
+	for(size_t i = 0; i < fileReferences.size(); i++)
+		os << "\t" << Quoted(fileReferences[i]) << ",\n";
+	os << "\tnullptr\n};\n\n";
+
+	//the names are only read when recording a draw trace
+	os << "static const char* const SpriteIdNames[SpriteId_Count + 1] =\n{\n";
+	for(size_t i = 0; i < sprites.size(); i++)
+		os << "\t" << Quoted(sprites[i].name) << ",\n";
+	os << "\tnullptr\n};\n\n";
+
+	os << "static const char* const AnimationIdNames[AnimationId_Count + 1] =\n{\n";
+	for(size_t i = 0; i < animations.size(); i++)
+		os << "\t" << Quoted(animations[i].name) << ",\n";
+	os << "\tnullptr\n};\n\n";
+
+	//every table gets a trailing entry so none of them is empty
+	os << "constexpr SpriteIdRect SpriteIdRects[SpriteId_Count + 1] =\n{\n";
+	for(size_t i = 0; i < sprites.size(); i++)
+	{
+		const SpriteEntry& s = sprites[i];
+		os << "\t{SpriteFileId_" << Identifier(fileReferences[s.file]) << ", " << s.x << ", " << s.y << ", "
+			<< s.w << ", " << s.h << ", " << s.sliceLeft << ", " << s.sliceTop << ", " << s.sliceRight << ", "
+			<< s.sliceBottom << "},\t//" << s.name << "\n";
+	}
+	os << "\t{0, 0, 0, 0, 0, 0, 0, 0, 0}\n};\n\n";
+
+	int frameCount = 0;
+	os << "constexpr AnimationIdInfo AnimationIdInfos[AnimationId_Count + 1] =\n{\n";
+	for(size_t i = 0; i < animations.size(); i++)
+	{
+		const AnimationEntry& a = animations[i];
+		os << "\t{SpriteFileId_" << Identifier(fileReferences[a.file]) << ", " << a.w << ", " << a.h << ", "
+			<< frameCount << ", " << a.frames.size() << ", " << a.animationType << ", " << FloatLiteral(a.frameDelay) << "},\t//"
+			<< a.name << "\n";
+		frameCount += (int)a.frames.size();
+	}
+	os << "\t{0, 0, 0, 0, 0, 0, 0.0f}\n};\n\n";
+
+	os << "constexpr AnimationIdFrame AnimationIdFrames[" << frameCount + 1 << "] =\n{\n";
+	for(size_t i = 0; i < animations.size(); i++)
+		for(size_t f = 0; f < animations[i].frames.size(); f++)
+			os << "\t{" << animations[i].frames[f].first << ", " << animations[i].frames[f].second << "},\n";
+	os << "\t{0, 0}\n};\n\n";
+
+	os << "inline void BindSpriteIdTextures()\n{\n\tBindTextureFileSlots(SpriteFileReferences, SpriteFileId_Count);\n}\n\n";
+
+	os << "inline SDL_Texture* GetTexture(SpriteId id)\n{\n"
+		<< "\tSDL_Texture* texture = GetTextureFileSlot(SpriteIdRects[id].file);\n\n"
+		<< "\tif(IsDrawTraceRecording())\n\t\tTraceGetTexture(TextureType_Sprite, SpriteIdNames[id], texture);\n\n"
+		<< "\treturn texture;\n}\n\n";
+	os << "inline SDL_Texture* GetTexture(AnimationId id)\n{\n"
+		<< "\tSDL_Texture* texture = GetTextureFileSlot(AnimationIdInfos[id].file);\n\n"
+		<< "\tif(IsDrawTraceRecording())\n\t\tTraceGetTexture(TextureType_Animation, AnimationIdNames[id], texture);\n\n"
+		<< "\treturn texture;\n}\n\n";
+
+	os << "inline void SetSpriteSourceRect(SpriteId id, SDL_Rect* source)\n{\n"
+		<< "\tsource->w = SpriteIdRects[id].w;\n\tsource->h = SpriteIdRects[id].h;\n"
+		<< "\tsource->x = SpriteIdRects[id].x;\n\tsource->y = SpriteIdRects[id].y;\n\n"
+		<< "\tif(IsDrawTraceRecording())\n\t\tTraceSpriteSourceRect(SpriteIdNames[id]);\n}\n\n";
+
+	os << "inline void DrawNineSliceSprite(SDL_Renderer* renderer, SpriteId id, const SDL_Rect* destination)\n{\n"
+		<< "\tconst SpriteIdRect& r = SpriteIdRects[id];\n"
+		<< "\tSDL_Rect source = {r.x, r.y, r.w, r.h};\n"
+		<< "\tSDL_Texture* texture = GetTextureFileSlot(r.file);\n\n"
+		<< "\tif(IsDrawTraceRecording())\n\t\tTraceGetTextureFileReference(SpriteFileReferences[r.file], texture);\n\n"
+		<< "\tDrawNineSlice(renderer, texture, &source, r.sliceLeft, r.sliceTop, r.sliceRight, r.sliceBottom, destination);\n}\n\n";
+
+	os << "inline void SetAnimationSourceRect(AnimationId id, const int frame, SDL_Rect* source)\n{\n"
+		<< "\tconst AnimationIdInfo& a = AnimationIdInfos[id];\n\n"
+		<< "\t//out of range frames show the nearest end, the same as the string version\n"
+		<< "\tint clamped = frame < 0 ? 0 : (frame >= a.frameCount ? a.frameCount - 1 : frame);\n"
+		<< "\tconst AnimationIdFrame& f = AnimationIdFrames[a.firstFrame + clamped];\n\n"
+		<< "\tsource->w = a.w;\n\tsource->h = a.h;\n"
+		<< "\tsource->x = f.x;\n\tsource->y = f.y;\n\n"
+		<< "\tif(IsDrawTraceRecording())\n\t\tTraceAnimationSourceRect(AnimationIdNames[id], frame);\n}\n\n";
+
+	os << "#endif //SPRITEIDS_H\n";
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 3)
+	{
+		fprintf(stderr, "usage: SpriteIdGenerator <output header> <data or source file>...\n");
+		return 1;
+	}
+
+	for(int i = 2; i < argc; i++)
+		if(!(IsSourceFile(argv[i]) ? ReadSourceFile(argv[i]) : ReadDataFile(argv[i])))
+			return 1;
+
+	std::vector<String> spriteNames, animationNames;
+	for(size_t i = 0; i < sprites.size(); i++)
+		spriteNames.push_back(sprites[i].name);
+	for(size_t i = 0; i < animations.size(); i++)
+		animationNames.push_back(animations[i].name);
+
+	if(!CheckUnique("SpriteFileId_", fileReferences) || !CheckUnique("SpriteId_", spriteNames) ||
+	   !CheckUnique("AnimationId_", animationNames))
+		return 1;
+
+	//build in memory and only replace the header when it changed so dependents do not rebuild
+	std::stringstream header;
+	WriteHeader(header);
+
+	std::ifstream existing(argv[1]);
+	if(existing.is_open())
+	{
+		std::stringstream current;
+		current << existing.rdbuf();
+		if(current.str() == header.str())
+			return 0;
+		existing.close();
+	}
+
+	std::ofstream output(argv[1]);
+	if(!output.is_open())
+	{
+		fprintf(stderr, "SpriteIdGenerator: error opening: %s\n", argv[1]);
+		return 1;
+	}
+	output << header.str();
+
+	return 0;
+}
@@ -0,0 +1,261 @@
+/**
+*    SurfaceBlendTest.cpp
+*
+*	Headless test for the outlined text compositing kernels. Every kernel built for this
+*	CPU blends random ARGB8888 surfaces and the result is compared byte for byte with
+*	SDL_BlitSurface using SDL_BLENDMODE_BLEND. Odd widths leave tail pixels for the scalar
+*	loop and offset blits start rows on unaligned pixels. The time per megapixel of each
+*	kernel and of SDL_BlitSurface is then printed. Returns 1 if any output differs:
+*
+*		SurfaceBlendTest [megapixel runs]
+*
+*	The reference is whichever blitter the linked SDL picks, so the result holds for that
+*	SDL build only. The kernels follow SDL 2.0's scalar BlitRGBtoRGBPixelAlpha; an SDL
+*	using its MMX, ARM SIMD or NEON blitter, or SDL 3's blend, is expected to differ.
+*
+*	Build it with SurfaceBlend.cpp and link SDL2.
+*/
+
+#include "stdafx.h"
+
+#include "SurfaceBlend.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static Uint32 randomState = 0x9e3779b9;
+
+static Uint32 Random()
+{
+	//xorshift, so runs are repeatable on every platform
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+static SDL_Surface* CreateRandomSurface(int width, int height)
+{
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+	if(!surface)
+		return nullptr;
+
+	for(int y = 0; y < height; y++)
+	{
+		Uint32* row = (Uint32*)((Uint8*)surface->pixels + y * surface->pitch);
+		for(int x = 0; x < width; x++)
+		{
+			//glyph surfaces are mostly clear or opaque, so both shortcuts get plenty of pixels
+			Uint32 r = Random();
+			Uint32 alpha = r % 4 == 0 ? 0 : (r % 4 == 1 ? 255 : (r >> 8) & 0xff);
+			row[x] = (alpha << 24) | (Random() & 0xffffff);
+		}
+	}
+
+	return surface;
+}
+
+static SDL_Surface* CopySurface(SDL_Surface* surface)
+{
+	SDL_Surface* copy = SDL_CreateRGBSurfaceWithFormat(0, surface->w, surface->h, 32, SDL_PIXELFORMAT_ARGB8888);
+	if(copy)
+		for(int y = 0; y < surface->h; y++)
+			memcpy((Uint8*)copy->pixels + y * copy->pitch, (Uint8*)surface->pixels + y * surface->pitch, surface->w * 4);
+
+	return copy;
+}
+
+/**
+*	Blend the source onto the destination at x, y with one kernel, clipped like SDL_BlitSurface
+*/
+static bool BlendWithKernel(BlendKernel kernel, SDL_Surface* source, SDL_Surface* destination, int x, int y)
+{
+	//an empty row only checks the kernel runs on this CPU
+	if(!BlendRowARGBWithKernel(kernel, nullptr, nullptr, 0))
+		return false;
+
+	int sourceX = x < 0 ? -x : 0;
+	int sourceY = y < 0 ? -y : 0;
+	int width = SDL_min(source->w - sourceX, destination->w - (x + sourceX));
+	int height = SDL_min(source->h - sourceY, destination->h - (y + sourceY));
+
+	for(int row = 0; row < height && width > 0; row++)
+	{
+		const Uint32* s = (const Uint32*)((const Uint8*)source->pixels + (sourceY + row) * source->pitch) + sourceX;
+		Uint32* d = (Uint32*)((Uint8*)destination->pixels + (y + sourceY + row) * destination->pitch) + x + sourceX;
+
+		BlendRowARGBWithKernel(kernel, s, d, width);
+	}
+
+	return true;
+}
+
+/**
+*	Return the first pixel that differs, -1 if the surfaces match
+*/
+static int FindDifference(SDL_Surface* a, SDL_Surface* b)
+{
+	for(int y = 0; y < a->h; y++)
+	{
+		const Uint8* rowA = (const Uint8*)a->pixels + y * a->pitch;
+		const Uint8* rowB = (const Uint8*)b->pixels + y * b->pitch;
+		if(memcmp(rowA, rowB, a->w * 4) != 0)
+			for(int x = 0; x < a->w; x++)
+				if(memcmp(rowA + x * 4, rowB + x * 4, 4) != 0)
+					return y * a->w + x;
+	}
+
+	return -1;
+}
+
+/**
+*	Compare every kernel with SDL_BlitSurface for one size and offset
+*/
+static bool TestBlend(int width, int height, int x, int y, bool* available)
+{
+	SDL_Surface* source = CreateRandomSurface(width, height);
+	SDL_Surface* destination = CreateRandomSurface(width + 3, height + 2);
+	SDL_Surface* expected = CopySurface(destination);
+	if(!source || !destination || !expected)
+	{
+		printf("error creating surfaces: %s\n", SDL_GetError());
+		return false;
+	}
+
+	SDL_SetSurfaceBlendMode(source, SDL_BLENDMODE_BLEND);
+	SDL_Rect position = {x, y, width, height};
+	SDL_BlitSurface(source, nullptr, expected, &position);
+
+	bool passed = true;
+
+	for(int kernel = 0; kernel < BlendKernel_Count; kernel++)
+	{
+		SDL_Surface* blended = CopySurface(destination);
+		available[kernel] = BlendWithKernel((BlendKernel)kernel, source, blended, x, y);
+
+		int difference = available[kernel] ? FindDifference(expected, blended) : -1;
+		if(difference >= 0)
+		{
+			printf("%s differs from SDL_BlitSurface: %dx%d at %d,%d, pixel %d,%d\n", GetBlendKernelName((BlendKernel)kernel),
+					width, height, x, y, difference % blended->w, difference / blended->w);
+			passed = false;
+		}
+
+		SDL_FreeSurface(blended);
+	}
+
+	//the dispatching entry point the game calls
+	SDL_Surface* blended = CopySurface(destination);
+	if(!BlendSurfaceARGB(source, blended, x, y) || FindDifference(expected, blended) >= 0)
+	{
+		printf("BlendSurfaceARGB differs from SDL_BlitSurface: %dx%d at %d,%d\n", width, height, x, y);
+		passed = false;
+	}
+
+	SDL_FreeSurface(blended);
+	SDL_FreeSurface(expected);
+	SDL_FreeSurface(destination);
+	SDL_FreeSurface(source);
+
+	return passed;
+}
+
+static double Milliseconds(Uint64 start, Uint64 end)
+{
+	return (double)(end - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+/**
+*	Time one megapixel blends, restoring the destination before each so every run blends the same pixels
+*/
+static void TimeBlends(int runs)
+{
+	SDL_Surface* source = CreateRandomSurface(1024, 1024);
+	SDL_Surface* destination = CreateRandomSurface(1024, 1024);
+	SDL_Surface* blended = CopySurface(destination);
+	if(!source || !destination || !blended)
+		return;
+
+	SDL_SetSurfaceBlendMode(source, SDL_BLENDMODE_BLEND);
+	int bytes = destination->pitch * destination->h;
+
+	for(int kernel = -1; kernel < BlendKernel_Count; kernel++)
+	{
+		double total = 0.0;
+		bool available = true;
+
+		for(int run = 0; run < runs && available; run++)
+		{
+			memcpy(blended->pixels, destination->pixels, bytes);
+
+			Uint64 start = SDL_GetPerformanceCounter();
+			if(kernel < 0)
+				SDL_BlitSurface(source, nullptr, blended, nullptr);
+			else
+				available = BlendWithKernel((BlendKernel)kernel, source, blended, 0, 0);
+			total += Milliseconds(start, SDL_GetPerformanceCounter());
+		}
+
+		const char* name = kernel < 0 ? "SDL_BlitSurface" : GetBlendKernelName((BlendKernel)kernel);
+		if(available)
+			printf("%-16s %8.3f ms per megapixel\n", name, total / (double)runs / (1024.0 * 1024.0 / 1000000.0));
+		else
+			printf("%-16s not available on this CPU\n", name);
+	}
+
+	SDL_FreeSurface(blended);
+	SDL_FreeSurface(destination);
+	SDL_FreeSurface(source);
+}
+
+int main(int argc, char** argv)
+{
+	int runs = argc > 1 ? atoi(argv[1]) : 50;
+	if(runs <= 0)
+		runs = 50;
+
+	if(SDL_Init(0) != 0)
+	{
+		printf("SDL_Init: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	//widths around each vector size so every kernel has a tail for the scalar loop
+	static const int widths[] = {1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 65, 127, 257, 1001};
+	static const int offsets[][2] = {{0, 0}, {1, 1}, {3, 0}, {-2, -1}, {5, 2}};
+
+	//the reference blit depends on this build of SDL, so name it in the output
+	SDL_version linked;
+	SDL_GetVersion(&linked);
+	printf("SDL %d.%d.%d\n", linked.major, linked.minor, linked.patch);
+
+	bool available[BlendKernel_Count] = {};
+	bool anyAvailable[BlendKernel_Count] = {};
+	int failed = 0;
+	int cases = 0;
+
+	for(size_t w = 0; w < SDL_arraysize(widths); w++)
+	{
+		for(size_t o = 0; o < SDL_arraysize(offsets); o++)
+		{
+			int height = 1 + (int)(Random() % 9);
+			if(!TestBlend(widths[w], height, offsets[o][0], offsets[o][1], available))
+				failed++;
+			cases++;
+
+			for(int k = 0; k < BlendKernel_Count; k++)
+				anyAvailable[k] = anyAvailable[k] || available[k];
+		}
+	}
+
+	for(int k = 0; k < BlendKernel_Count; k++)
+		printf("%-16s %s\n", GetBlendKernelName((BlendKernel)k), anyAvailable[k] ? "tested" : "not available on this CPU");
+	printf("%d of %d cases match SDL_BlitSurface\n\n", cases - failed, cases);
+
+	TimeBlends(runs);
+
+	SDL_Quit();
+
+	return failed == 0 ? 0 : 1;
+}